@@ -0,0 +1,202 @@
+/**
+ * @file bench.c
+ *
+ * @brief This file contains the benchmark harness run under the PIC16
+ *        simulator for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "hal.h"
+#include "thermosera.h"
+#include "i2c.h"
+#include "usb_cdc.h"
+#include "uart.h"
+#include "mcp3424.h"
+#include "thermocouple.h"
+#include "settings.h"
+#include "bench.h"
+
+#define BENCH_REPEAT 4
+
+volatile unsigned char bench_marker;
+
+// firmware internals exercised by the benchmarks
+extern I2C_TRANSACTION mcp3424_transaction;
+extern unsigned char mcp3424_buffer[4];
+extern unsigned char mcp3424_operation;
+extern unsigned configured;
+extern volatile EndpointPingPongType ep1;
+extern volatile unsigned char txbuffer_writepos;
+extern volatile unsigned char txbuffer_readpos;
+extern volatile unsigned char uart_txbuffer_writepos;
+extern volatile unsigned char uart_txbuffer_readpos;
+extern volatile unsigned char uart_baudrate_pos;
+extern int24_t emf[CHANNELS_NROF];
+extern signed short temperature[CHANNELS_NROF];
+extern signed short ambient;
+extern unsigned char valid;
+
+void print_degree(int24_t val, unsigned char decimals);
+void print_str(char * s);
+void print_asciiFrame(unsigned char mask);
+void print_binaryFrame(unsigned char mask);
+void compensate(unsigned char i);
+void usb_txprocess();
+
+/**
+ * @brief Fill all channels with worst case values (5 digits with sign)
+ */
+void bench_fillValues() {
+    unsigned char i;
+    for (i = 0; i < CHANNELS_NROF; i++) {
+        emf[i] = 54886; // type K, 1372 degree
+        temperature[i] = -1999;
+    }
+    ambient = -550;
+    valid = FRAME_MASK_CHANNELS | FRAME_MASK_AMBIENT;
+}
+
+/**
+ * @brief Previous formatter with software division, reference for print_degree()
+ *
+ * Kept unchanged except for the name, so both formatters are measured on
+ * the same value.
+ *
+ * @param val Temperature value to print out
+ */
+void bench_printDegreeDivision(int24_t val) {
+    char s[10];
+    unsigned char neg = 0;
+
+    if (val < 0) {
+        neg = 1;
+        val = -val;
+    }
+
+    char pos = 7;
+    while (pos > 0) {
+
+        pos--;
+
+        if (pos == 5) {
+            s[pos] = '.';
+        } else if ((pos > 3) || (val != 0)) {
+            s[pos] = '0' + (val % 10);
+            val = val / 10;
+        } else if (neg) {
+            s[pos] = '-';
+            neg = 0;
+        } else {
+            s[pos] = ' ';
+        }
+
+    }
+    s[7] = 0;
+    print_str(s);
+}
+
+/**
+ * @brief Discard output produced by a benchmark
+ */
+void bench_flush() {
+    usb_txCommit();
+    txbuffer_readpos = txbuffer_writepos;
+    uart_txbuffer_readpos = uart_txbuffer_writepos;
+    uart_baudrate_pos = uart_txbuffer_writepos;
+    TXIE = 0;
+}
+
+/**
+ * @brief Run benchmarks of the hot paths
+ *
+ * Each routine is enclosed by its BENCH_ID_xxx and BENCH_ID_END marker.
+ * Called once before interrupts are enabled, so no interrupt routine
+ * is counted. Peripherals are stimulated by presetting the state the
+ * interrupt routines would leave behind.
+ */
+void bench_run() {
+
+    unsigned char i;
+    int24_t value;
+
+    bench_fillValues();
+
+    for (i = 0; i < BENCH_REPEAT; i++) {
+
+        // cost of the markers themselves
+        BENCH_MARK(BENCH_ID_CALIBRATE);
+        BENCH_MARK(BENCH_ID_END);
+
+        BENCH_MARK(BENCH_ID_PRINT_DEGREE);
+        print_degree(-1999, VALUE_DECIMALS);
+        BENCH_MARK(BENCH_ID_END);
+        bench_flush();
+
+        BENCH_MARK(BENCH_ID_PRINT_DEGREE_DIVISION);
+        bench_printDegreeDivision(-1999);
+        BENCH_MARK(BENCH_ID_END);
+        bench_flush();
+
+        BENCH_MARK(BENCH_ID_PRINT_ASCIIFRAME);
+        print_asciiFrame(FRAME_MASK_CHANNELS | FRAME_MASK_AMBIENT);
+        BENCH_MARK(BENCH_ID_END);
+        bench_flush();
+
+        BENCH_MARK(BENCH_ID_PRINT_BINARYFRAME);
+        print_binaryFrame(FRAME_MASK_CHANNELS | FRAME_MASK_AMBIENT);
+        BENCH_MARK(BENCH_ID_END);
+        bench_flush();
+
+        // finished read transaction of a negative 18 bit result at gain 8
+        mcp3424_operation = MCP3424_OPERATION_READ;
+        mcp3424_transaction.status = I2C_STATUS_DONE;
+        mcp3424_buffer[0] = 0xfe;
+        mcp3424_buffer[1] = 0x12;
+        mcp3424_buffer[2] = 0x34;
+        mcp3424_buffer[3] = MCP3424_CONFIG_DEFAULT;
+        BENCH_MARK(BENCH_ID_MCP3424_READRESULT);
+        mcp3424_readConversationResult(&value, MCP3424_CONFIG_DEFAULT);
+        BENCH_MARK(BENCH_ID_END);
+
+        BENCH_MARK(BENCH_ID_THERMOCOUPLE_GETEMF);
+        thermocouple_getEmf(THERMOCOUPLE_TYPE_K, 255);
+        BENCH_MARK(BENCH_ID_END);
+
+        BENCH_MARK(BENCH_ID_THERMOCOUPLE_GETTEMPERATURE);
+        thermocouple_getTemperature(THERMOCOUPLE_TYPE_K, 54000);
+        BENCH_MARK(BENCH_ID_END);
+
+        BENCH_MARK(BENCH_ID_COMPENSATE);
+        compensate(0);
+        BENCH_MARK(BENCH_ID_END);
+
+        // configured device with free IN buffers and full send buffer
+        configured = 1;
+        ep1.in[0].stat = 0;
+        ep1.in[1].stat = 0;
+        txbuffer_readpos = 0;
+        txbuffer_writepos = TXBUFFER_SIZE - 1;
+        BENCH_MARK(BENCH_ID_USB_TXPROCESS);
+        usb_txprocess();
+        BENCH_MARK(BENCH_ID_END);
+        configured = 0;
+        ep1.in[0].stat = 0;
+        ep1.in[1].stat = 0;
+        bench_flush();
+    }
+}
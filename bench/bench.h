@@ -0,0 +1,60 @@
+/**
+ * @file bench.h
+ *
+ * @brief This file contains the benchmark instrumentation for the THERMOsera
+ *        firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#ifndef BENCH_H
+#define	BENCH_H
+
+/*
+ * Marker values written to bench_marker. The simulator logs every write with
+ * its cycle count, report.py takes the names from the BENCH_ID_xxx defines.
+ */
+#define BENCH_ID_CALIBRATE 0x00
+#define BENCH_ID_PRINT_DEGREE 0x01
+#define BENCH_ID_PRINT_ASCIIFRAME 0x02
+#define BENCH_ID_PRINT_BINARYFRAME 0x03
+#define BENCH_ID_MCP3424_READRESULT 0x04
+#define BENCH_ID_THERMOCOUPLE_GETEMF 0x05
+#define BENCH_ID_THERMOCOUPLE_GETTEMPERATURE 0x06
+#define BENCH_ID_COMPENSATE 0x07
+#define BENCH_ID_USB_TXPROCESS 0x08
+#define BENCH_ID_PRINT_DEGREE_DIVISION 0x09
+#define BENCH_ID_LOOP 0xFE
+#define BENCH_ID_END 0xFF
+
+#ifdef BENCHMARK
+
+extern volatile unsigned char bench_marker;
+
+#define BENCH_MARK(id) bench_marker = (id)
+
+void bench_run();
+
+#else
+
+#define BENCH_MARK(id)
+#define bench_run()
+
+#endif
+
+#endif
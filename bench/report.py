@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+#
+# Evaluate the gpsim log of the THERMOsera benchmark
+#
+# Every benchmark is enclosed by its BENCH_ID_xxx marker and BENCH_ID_END,
+# the marker overhead (BENCH_ID_CALIBRATE) is subtracted. The main loop
+# latency is the distance between consecutive BENCH_ID_LOOP markers. The
+# result is printed as JSON. With a baseline file, the script fails if a
+# value grew by more than the given tolerance.
+#
+#   report.py bench.h bench.log [baseline.json [tolerance_percent]]
+#
+
+import json
+import re
+import sys
+
+
+def read_ids(filename):
+    ids = {}
+    for line in open(filename):
+        m = re.match(r'#define\s+BENCH_ID_(\w+)\s+(0x[0-9A-Fa-f]+|\d+)', line)
+        if m:
+            ids[int(m.group(2), 0)] = m.group(1).lower()
+    return ids
+
+
+def read_log(filename):
+    # lines look like "0x<cycle> ... wrote: 0x<value> to bench_marker(...)"
+    writes = []
+    for line in open(filename):
+        m = re.search(r'wrote:?\s*(0x[0-9A-Fa-f]+)', line)
+        if not m:
+            continue
+        cycle = re.search(r'0x[0-9A-Fa-f]+', line)
+        writes.append((int(cycle.group(0), 16), int(m.group(1), 16)))
+    return writes
+
+
+def evaluate(ids, writes):
+    end = [k for k, v in ids.items() if v == 'end'][0]
+    loop = [k for k, v in ids.items() if v == 'loop'][0]
+
+    samples = {}
+    for (c0, v0), (c1, v1) in zip(writes, writes[1:]):
+        if v0 in (end, loop) or v1 != end:
+            continue
+        samples.setdefault(ids.get(v0, hex(v0)), []).append(c1 - c0)
+
+    overhead = min(samples.pop('calibrate', [0]))
+    functions = {}
+    for name, cycles in samples.items():
+        functions[name] = {
+            'min_cycles': min(cycles) - overhead,
+            'max_cycles': max(cycles) - overhead,
+        }
+
+    stamps = [c for c, v in writes if v == loop]
+    deltas = [b - a for a, b in zip(stamps, stamps[1:])]
+    result = {'functions': functions}
+    if deltas:
+        result['loop'] = {
+            'iterations': len(deltas),
+            'avg_cycles': sum(deltas) // len(deltas),
+            'max_cycles': max(deltas),
+        }
+    return result
+
+
+def compare(result, baseline, tolerance):
+    failed = []
+    for name, values in baseline.get('functions', {}).items():
+        current = result['functions'].get(name)
+        if current and current['max_cycles'] > values['max_cycles'] * (100 + tolerance) / 100:
+            failed.append('%s: %d > %d' % (name, current['max_cycles'], values['max_cycles']))
+    if 'loop' in baseline and 'loop' in result:
+        if result['loop']['max_cycles'] > baseline['loop']['max_cycles'] * (100 + tolerance) / 100:
+            failed.append('loop: %d > %d' % (result['loop']['max_cycles'], baseline['loop']['max_cycles']))
+    return failed
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: report.py bench.h bench.log [baseline.json [tolerance_percent]]')
+
+    result = evaluate(read_ids(sys.argv[1]), read_log(sys.argv[2]))
+    print(json.dumps(result, indent=2, sort_keys=True))
+
+    if len(sys.argv) > 3:
+        tolerance = float(sys.argv[4]) if len(sys.argv) > 4 else 5
+        try:
+            baseline = json.load(open(sys.argv[3]))
+        except IOError:
+            sys.exit('no baseline %s, create it with \'make baseline\'' % sys.argv[3])
+        failed = compare(result, baseline, tolerance)
+        for line in failed:
+            sys.stderr.write('regression %s\n' % line)
+        if failed:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
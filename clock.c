@@ -26,14 +26,17 @@
 #include "clock.h"
 
 unsigned char clock_tickerSlow;
+volatile unsigned long clock_millis = 0;
+unsigned char clock_divider = CLOCK_SLOW_DIVIDER;
 
 /**
  * @brief Initialize timer module
  */
 void clock_init() {
-    // enable timer 1 with 1:8 -> 1.5MHz
-    T1CON = 0b00110001;
-    TMR1IE = 1;
+    // enable timer 2 with 1:16 prescaler, 250 counts and 1:3 postscaler -> 1 kHz
+    PR2 = 249;
+    T2CON = 0b00010110;
+    TMR2IE = 1;
 }
 
 unsigned char toggle = 0;
@@ -41,8 +44,25 @@ unsigned char toggle = 0;
  * @brief Timer interrupt routine
  */
 inline void clock_isr() {
-    TMR1 = 0xffff - 15000 + 50; // reload for 100 Hz
+    clock_millis++;
+
+    clock_divider--;
+    if (clock_divider) return;
+    clock_divider = CLOCK_SLOW_DIVIDER;
+
     clock_tickerSlow++;
     LATCbits.LATC3 = toggle;
     toggle = !toggle;
 }
+
+/**
+ * @brief Get milliseconds since reset
+ *
+ * @return Milliseconds, wraps after 49 days
+ */
+unsigned long clock_getMillis() {
+    TMR2IE = 0;
+    unsigned long millis = clock_millis;
+    TMR2IE = 1;
+    return millis;
+}
@@ -27,10 +27,14 @@
 
 void clock_init();
 inline void clock_isr();
+unsigned long clock_getMillis();
+
+#define CLOCK_SLOW_DIVIDER 10 // 1 ms -> 10 ms
 
 #define clock_diff(x) ((unsigned char) (clock_tickerSlow - x))
 
 extern unsigned char clock_tickerSlow;
+extern volatile unsigned long clock_millis;
 
 #endif
 
@@ -0,0 +1,144 @@
+/**
+ * @file filter.c
+ *
+ * @brief This file contains the digital filters for the ADC results of the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "settings.h"
+#include "filter.h"
+
+// filter state, the IIR state shares the memory of the sample ring
+typedef union {
+    int24_t samples[FILTER_SAMPLES]; // last samples
+    signed long iir; // IIR state with fractional bits
+} FILTER_STATE;
+
+FILTER_STATE filter_state[CHANNELS_NROF];
+unsigned char filter_count[CHANNELS_NROF]; // samples fed, param..2*param-1 once filled
+
+/**
+ * @brief Set filter of given channel
+ *
+ * @param channel Channel index
+ * @param type Filter type (FILTER_TYPE_xxx)
+ * @param param Filter parameter, see FILTER_TYPE_xxx
+ * @retval 1 Successful
+ * @retval 0 Invalid type or parameter
+ */
+unsigned char filter_set(unsigned char channel, unsigned char type, unsigned char param) {
+
+    switch (type) {
+        case FILTER_TYPE_NONE:
+            param = 0;
+            break;
+        case FILTER_TYPE_BOXCAR:
+            if ((param < 2) || (param > FILTER_SAMPLES)) return 0;
+            break;
+        case FILTER_TYPE_IIR:
+            if ((param < 1) || (param > 7)) return 0;
+            break;
+        case FILTER_TYPE_MEDIAN:
+            if ((param != 3) && (param != 5)) return 0;
+            break;
+        default:
+            return 0;
+    }
+
+    settings.filtertype[channel] = type;
+    settings.filterparam[channel] = param;
+    filter_reset(channel);
+    return 1;
+}
+
+/**
+ * @brief Discard filter history of given channel
+ * @param channel Channel index
+ */
+void filter_reset(unsigned char channel) {
+    filter_count[channel] = 0;
+}
+
+/**
+ * @brief Feed ADC result into filter of given channel
+ *
+ * Until the filter is filled, the boxcar and the median work on the
+ * samples available so far.
+ *
+ * @param channel Channel index
+ * @param value ADC result (uV)
+ * @return Filtered value (uV)
+ */
+int24_t filter_apply(unsigned char channel, int24_t value) {
+
+    unsigned char type = settings.filtertype[channel];
+    unsigned char param = settings.filterparam[channel];
+    unsigned char fed = filter_count[channel];
+    FILTER_STATE * state = &filter_state[channel];
+
+    if (type == FILTER_TYPE_NONE) return value;
+
+    if (type == FILTER_TYPE_IIR) {
+        signed long x = (signed long) value << FILTER_IIR_FRACTION;
+        if (fed == 0) {
+            state->iir = x;
+            filter_count[channel] = 1;
+        } else {
+            state->iir += (x - state->iir) >> param;
+        }
+        return (state->iir + (1 << (FILTER_IIR_FRACTION - 1))) >> FILTER_IIR_FRACTION;
+    }
+
+    // boxcar and median work on the last samples
+    int24_t * samples = state->samples;
+    unsigned char pos = fed;
+    if (pos >= param) pos -= param;
+    samples[pos] = value;
+
+    fed++;
+    if (fed == 2 * param) fed = param;
+    filter_count[channel] = fed;
+    unsigned char count = fed;
+    if (count > param) count = param;
+
+    unsigned char i;
+
+    if (type == FILTER_TYPE_BOXCAR) {
+        signed long sum = 0;
+        for (i = 0; i < count; i++) {
+            sum += samples[i];
+        }
+        return sum / count;
+    }
+
+    // median: sample with as many smaller samples as the middle position
+    unsigned char middle = count >> 1;
+    for (i = 0; i < count; i++) {
+        unsigned char smaller = 0;
+        unsigned char equal = 0;
+        unsigned char j;
+        for (j = 0; j < count; j++) {
+            if (samples[j] < samples[i]) smaller++;
+            else if (samples[j] == samples[i]) equal++;
+        }
+        if ((smaller <= middle) && (smaller + equal > middle)) break;
+    }
+    return samples[i];
+}
@@ -0,0 +1,43 @@
+/**
+ * @file filter.h
+ *
+ * @brief This file contains the definitions for the digital filters of the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef FILTER_H
+#define	FILTER_H
+
+#define FILTER_TYPE_NONE 0
+#define FILTER_TYPE_BOXCAR 1 // parameter: count of averaged samples (2..5)
+#define FILTER_TYPE_IIR 2 // parameter: k (1..7), y += (x - y) / 2^k
+#define FILTER_TYPE_MEDIAN 3 // parameter: count of samples (3 or 5)
+#define FILTER_TYPE_NROF 4
+
+// type letters in order of FILTER_TYPE_xxx
+#define FILTER_TYPE_LETTERS "-AIM"
+
+#define FILTER_SAMPLES 5
+#define FILTER_IIR_FRACTION 8 // fractional bits of IIR state
+
+unsigned char filter_set(unsigned char channel, unsigned char type, unsigned char param);
+void filter_reset(unsigned char channel);
+int24_t filter_apply(unsigned char channel, int24_t value);
+
+#endif
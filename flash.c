@@ -0,0 +1,100 @@
+/**
+ * @file flash.c
+ *
+ * @brief This file contains the flash memory routines for the THERMOsera
+ *        firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "flash.h"
+
+/**
+ * @brief Execute unlock sequence and start write/erase operation
+ */
+void flash_unlock() {
+
+    unsigned char gie = GIE;
+    GIE = 0;
+
+    PMCON2 = 0x55;
+    PMCON2 = 0xAA;
+    PMCON1bits.WR = 1;
+    NOP();
+    NOP();
+
+    GIE = gie;
+}
+
+/**
+ * @brief Read low byte of given program memory word
+ * @param address Program memory address
+ * @return Low byte of program memory word
+ */
+unsigned char flash_read(unsigned short address) {
+
+    PMCON1bits.CFGS = 0;
+    PMADRL = address & 0xff;
+    PMADRH = address >> 8;
+    PMCON1bits.RD = 1;
+    NOP();
+    NOP();
+
+    return PMDATL;
+}
+
+/**
+ * @brief Erase and write one program memory row
+ *
+ * Only the low byte of each word is used (high-endurance flash). The high
+ * byte is set to a retlw opcode like the compiler does for const data.
+ *
+ * @param address Start address of row (must be row aligned)
+ * @param data Data to write
+ * @param length Count of bytes to write, rest of row is filled with 0xff
+ */
+void flash_writeRow(unsigned short address, unsigned char * data, unsigned char length) {
+
+    // erase row
+    PMCON1bits.CFGS = 0;
+    PMADRL = address & 0xff;
+    PMADRH = address >> 8;
+    PMCON1bits.FREE = 1;
+    PMCON1bits.WREN = 1;
+    flash_unlock();
+
+    // load write latches
+    PMCON1bits.LWLO = 1;
+
+    unsigned char i;
+    for (i = 0; i < FLASH_ROWSIZE; i++) {
+
+        PMADRL = (address + i) & 0xff;
+        PMADRH = (address + i) >> 8;
+        PMDATH = 0x34;
+        if (i < length) PMDATL = data[i];
+        else PMDATL = 0xff;
+
+        // last word: write latches to flash
+        if (i == FLASH_ROWSIZE - 1) PMCON1bits.LWLO = 0;
+
+        flash_unlock();
+    }
+
+    PMCON1bits.WREN = 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file flash.h
+ *
+ * @brief This file contains the definitions for flash memory functions for
+ *        the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef FLASH_H
+#define	FLASH_H
+
+#define FLASH_ROWSIZE 32
+#define FLASH_HEF_ADDRESS 0x1F80
+#define FLASH_END_ADDRESS 0x2000 // end of program memory
+
+unsigned char flash_read(unsigned short address);
+void flash_writeRow(unsigned short address, unsigned char * data, unsigned char length);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file hal.h
+ *
+ * @brief This file contains the hardware abstraction for the THERMOsera
+ *        firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#ifndef HAL_H
+#define	HAL_H
+
+/*
+ * The peripheral drivers (clock, uart, i2c, flash, usb_cdc) are the boundary
+ * to the hardware. The host build (HAL_HOST, see host/) replaces them with
+ * simulated devices and provides the few registers used by main.c.
+ */
+#ifdef HAL_HOST
+
+#include "host/host.h"
+
+#else
+
+#include <xc.h>
+#include <stdint.h>
+
+// place object at absolute address
+#define HAL_AT(address) @ address
+
+// jump to reset vector (bootloader)
+#define HAL_RESET() asm("ljmp 0x000")
+
+#endif
+
+#endif
@@ -0,0 +1,284 @@
+/**
+ * @file history.c
+ *
+ * @brief This file contains the sample history ring buffer of the THERMOsera
+ *        firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "clock.h"
+#include "usb_cdc.h"
+#include "history.h"
+
+// ring of blocks, the oldest block is overwritten when all are in use
+unsigned char history_blocks[HISTORY_BLOCKS][HISTORY_BLOCKSIZE];
+unsigned char history_head = 0; // block written to
+unsigned char history_used = 0; // count of blocks in use
+unsigned char history_sequence = 0;
+unsigned long history_lasttime = 0; // ms of newest record, on the 10 ms grid of the record times
+signed short history_last[CHANNELS_NROF + 1]; // reference for differences
+
+unsigned short history_lost = 0; // records dropped while dumping
+unsigned short history_dumpleft = 0;
+unsigned char history_dumpblock;
+unsigned char history_dumppos;
+
+/**
+ * @brief Encode record
+ *
+ * @param record Buffer for encoded record
+ * @param time Time units since previous record (up to HISTORY_TIME_MAX)
+ * @param mask Values to encode (FRAME_MASK_xxx)
+ * @param values Values to encode (0.1 degree)
+ * @param last Values of previous record, 0 for 16 bit values
+ * @return Length of encoded record
+ */
+unsigned char history_encode(unsigned char * record, unsigned short time, unsigned char mask, signed short * values, signed short * last) {
+
+    unsigned char length = 0;
+    if (time >= HISTORY_TIME_ESCAPE) {
+        record[length++] = HISTORY_TIME_ESCAPE;
+        record[length++] = (unsigned char) (time >> 8);
+    }
+    record[length++] = (unsigned char) time;
+
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+
+        if (!(mask & (1 << i))) continue;
+
+        if (last) {
+            int24_t delta = (int24_t) values[i] - last[i];
+            if ((delta > -128) && (delta < 128)) {
+                record[length++] = (unsigned char) delta;
+                continue;
+            }
+            record[length++] = HISTORY_DELTA_ESCAPE;
+        }
+
+        record[length++] = (unsigned char) (values[i] >> 8);
+        record[length++] = (unsigned char) values[i];
+    }
+
+    return length;
+}
+
+/**
+ * @brief Convert values to the 16 bit values of the records
+ *
+ * @param current Converted values
+ * @param values Channel values and ambient value (0.1 degree or
+ *        VALUE_INVALID_BINARY)
+ */
+void history_convert(signed short * current, int24_t * values) {
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+        if (values[i] == VALUE_INVALID_BINARY) current[i] = HISTORY_VALUE_INVALID;
+        else current[i] = (signed short) values[i];
+    }
+}
+
+/**
+ * @brief Start block with given record
+ *
+ * @param block Block to initialize
+ * @param sequence Sequence counter of block
+ * @param mask Values (FRAME_MASK_xxx) and time unit
+ * @param time Time units since previous record
+ * @param values Values of record (0.1 degree)
+ * @param last Reference for the following records, set to values
+ */
+void history_startBlock(unsigned char * block, unsigned char sequence, unsigned char mask, unsigned short time, signed short * values, signed short * last) {
+
+    block[HISTORY_HEADER_SEQUENCE] = sequence;
+    block[HISTORY_HEADER_MASK] = mask;
+    block[HISTORY_HEADER_LENGTH] = HISTORY_HEADER_SIZE +
+            history_encode(&block[HISTORY_HEADER_SIZE], time, mask, values, 0);
+
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+        last[i] = values[i];
+    }
+}
+
+/**
+ * @brief Append record to block
+ *
+ * @param block Block to append to (length 0 if unused)
+ * @param mask Values (FRAME_MASK_xxx) and time unit
+ * @param time Time units since previous record
+ * @param values Values of record (0.1 degree)
+ * @param last Values of previous record, set to values
+ * @retval 1 record appended
+ * @retval 0 block unused, full or mask differs, start a new one
+ */
+unsigned char history_append(unsigned char * block, unsigned char mask, unsigned short time, signed short * values, signed short * last) {
+
+    unsigned char record[3 + 3 * (CHANNELS_NROF + 1)];
+
+    if ((block[HISTORY_HEADER_LENGTH] == 0) || (block[HISTORY_HEADER_MASK] != mask)) return 0;
+
+    unsigned char length = history_encode(record, time, mask, values, last);
+    unsigned char pos = block[HISTORY_HEADER_LENGTH];
+    if (pos + length > HISTORY_BLOCKSIZE) return 0;
+
+    unsigned char i;
+    for (i = 0; i < length; i++) {
+        block[pos++] = record[i];
+    }
+    block[HISTORY_HEADER_LENGTH] = pos;
+
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+        last[i] = values[i];
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Add record to history
+ *
+ * A new block is started if the record doesn't fit into the current one or
+ * the mask has changed. While a dump is in progress, the oldest block isn't
+ * overwritten and the record is dropped instead.
+ *
+ * @param mask Values to add (FRAME_MASK_xxx)
+ * @param values Channel values and ambient value (0.1 degree or
+ *        VALUE_INVALID_BINARY)
+ */
+void history_add(unsigned char mask, int24_t * values) {
+
+    signed short current[CHANNELS_NROF + 1];
+    history_convert(current, values);
+
+    // 10 ms ticks since previous record, longer gaps are limited
+    unsigned long now = clock_getMillis();
+    unsigned long elapsed = now - history_lasttime;
+    unsigned short time = HISTORY_TIME_MAX;
+    if (elapsed < HISTORY_TIME_MAX * 10UL) time = (unsigned short) (elapsed / 10);
+
+    if (!history_append(history_blocks[history_head], mask, time, current, history_last)) {
+
+        if (history_dumpleft && (history_used == HISTORY_BLOCKS)) {
+            history_lost++;
+            return;
+        }
+
+        if (history_used) {
+            history_head++;
+            if (history_head == HISTORY_BLOCKS) history_head = 0;
+        }
+        if (history_used < HISTORY_BLOCKS) history_used++;
+
+        history_startBlock(history_blocks[history_head], history_sequence++, mask, time, current, history_last);
+    }
+
+    // stay on the grid of the record times, so the rounding doesn't add up
+    if (time == HISTORY_TIME_MAX) history_lasttime = now;
+    else history_lasttime += time * 10UL;
+}
+
+/**
+ * @brief Determine the time covered by the records in the history
+ *
+ * The time units of all records are summed up, except of the first record
+ * of the oldest block, whose time refers to a record already overwritten.
+ *
+ * @return ms from oldest to newest record
+ */
+unsigned long history_getSpan() {
+
+    unsigned long ticks = 0;
+    unsigned char block = (history_head + HISTORY_BLOCKS + 1 - history_used) % HISTORY_BLOCKS;
+    unsigned char n;
+    for (n = 0; n < history_used; n++) {
+
+        unsigned char * b = history_blocks[block];
+        unsigned char mask = b[HISTORY_HEADER_MASK] & HISTORY_MASK_VALUES;
+        unsigned char pos = HISTORY_HEADER_SIZE;
+        while (pos < b[HISTORY_HEADER_LENGTH]) {
+
+            unsigned char first = (pos == HISTORY_HEADER_SIZE);
+            unsigned short time = b[pos++];
+            if (time == HISTORY_TIME_ESCAPE) {
+                time = (b[pos] << 8) | b[pos + 1];
+                pos += 2;
+            }
+            if (n || !first) ticks += time;
+
+            // skip values, 16 bit in the first record, escaped or 8 bit difference in the following ones
+            unsigned char i;
+            for (i = 0; i <= CHANNELS_NROF; i++) {
+                if (!(mask & (1 << i))) continue;
+                if (first) pos += 2;
+                else if (b[pos] == HISTORY_DELTA_ESCAPE) pos += 3;
+                else pos++;
+            }
+        }
+
+        block++;
+        if (block == HISTORY_BLOCKS) block = 0;
+    }
+
+    return ticks * 10;
+}
+
+/**
+ * @brief Start dump of all blocks in use, oldest first
+ *
+ * @return Count of bytes to dump
+ */
+unsigned short history_dumpStart() {
+    history_dumpblock = (history_head + HISTORY_BLOCKS + 1 - history_used) % HISTORY_BLOCKS;
+    history_dumppos = 0;
+    history_dumpleft = history_used * HISTORY_BLOCKSIZE;
+    return history_dumpleft;
+}
+
+/**
+ * @brief Put as much of the pending dump into the USB send buffer as fits
+ *
+ * The dump is aborted if the host closes the port.
+ */
+void history_dumpProcess() {
+
+    if (!history_dumpleft) return;
+
+    if (!usb_isOpen()) {
+        history_dumpleft = 0;
+        return;
+    }
+
+    unsigned char free = usb_txFree();
+    while (free && history_dumpleft) {
+
+        usb_putch(history_blocks[history_dumpblock][history_dumppos]);
+        free--;
+        history_dumpleft--;
+
+        history_dumppos++;
+        if (history_dumppos == HISTORY_BLOCKSIZE) {
+            history_dumppos = 0;
+            history_dumpblock++;
+            if (history_dumpblock == HISTORY_BLOCKS) history_dumpblock = 0;
+        }
+    }
+
+    usb_txCommit();
+}
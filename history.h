@@ -0,0 +1,78 @@
+/**
+ * @file history.h
+ *
+ * @brief This file contains the definitions for the sample history of the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef HISTORY_H
+#define	HISTORY_H
+
+#include "flash.h"
+
+/*
+ * Block layout (size of a flash row):
+ *   sequence counter, used length incl. header, value mask (FRAME_MASK_xxx)
+ *   with time unit in bit 5-7, records
+ * Record layout:
+ *   time units since previous record (255 and more as escape byte followed
+ *   by the 16 bit time, MSB first), one value per bit in mask (0.1 degree)
+ * The first record of a block holds 16 bit values (signed, MSB first), the
+ * following ones the signed 8 bit difference to the previous record or the
+ * escape byte followed by the 16 bit value.
+ *
+ * Retention: with four channels and ambient a block holds 4 records (11
+ * bytes for the first, 6 for each following one), so the history keeps the
+ * last 21..24 scans, e.g. 2 s at 100 ms scan interval or 20 s at 1 s. A
+ * single channel with ambient gives 9 records per block, steps beyond the
+ * 8 bit difference give fewer. The 'H' reply states the time covered.
+ */
+#define HISTORY_BLOCKSIZE FLASH_ROWSIZE
+#define HISTORY_BLOCKS 6
+
+#define HISTORY_HEADER_SEQUENCE 0
+#define HISTORY_HEADER_LENGTH 1
+#define HISTORY_HEADER_MASK 2
+#define HISTORY_HEADER_SIZE 3
+
+#define HISTORY_MASK_VALUES 0x1F
+#define HISTORY_MASK_TIMEUNIT_SHIFT 5
+
+/* Time unit of records, 1..7 is the logger interval (LOGGER_INTERVAL_xxx) */
+#define HISTORY_TIMEUNIT_TICKS 0 // 10 ms
+
+#define HISTORY_TIME_ESCAPE 0xFF
+#define HISTORY_TIME_MAX 0xFFFF // longer gaps are recorded as this
+
+#define HISTORY_DELTA_ESCAPE 0x80
+#define HISTORY_VALUE_INVALID ((signed short) 0x8000)
+
+void history_convert(signed short * current, int24_t * values);
+void history_startBlock(unsigned char * block, unsigned char sequence, unsigned char mask, unsigned short time, signed short * values, signed short * last);
+unsigned char history_append(unsigned char * block, unsigned char mask, unsigned short time, signed short * values, signed short * last);
+void history_add(unsigned char mask, int24_t * values);
+unsigned long history_getSpan();
+unsigned short history_dumpStart();
+void history_dumpProcess();
+
+extern unsigned short history_dumpleft;
+extern unsigned short history_lost;
+extern unsigned long history_lasttime;
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file clock.c
+ *
+ * @brief This file contains the simulated timer of the native host build
+ *        for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "clock.h"
+
+unsigned char clock_tickerSlow;
+volatile unsigned long clock_millis = 0;
+
+/**
+ * @brief Initialize timer module
+ */
+void clock_init() {
+    // ticks are generated by sim_poll()
+    TMR2IE = 1;
+}
+
+/**
+ * @brief Timer interrupt routine, raised every 10 ms by sim_poll()
+ */
+inline void clock_isr() {
+    clock_millis += 10;
+    clock_tickerSlow++;
+}
+
+/**
+ * @brief Get milliseconds since start
+ *
+ * @return Milliseconds
+ */
+unsigned long clock_getMillis() {
+    return clock_millis;
+}
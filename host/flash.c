@@ -0,0 +1,96 @@
+/**
+ * @file flash.c
+ *
+ * @brief This file contains the simulated high-endurance flash of the native
+ *        host build for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thermosera.h"
+#include "flash.h"
+#include "logger.h"
+
+// log rows and HEF up to the end of program memory
+#define FLASH_SIM_ADDRESS LOGGER_FLASH_ADDRESS
+#define FLASH_SIM_SIZE (FLASH_END_ADDRESS - FLASH_SIM_ADDRESS)
+
+unsigned char flash_data[FLASH_SIM_SIZE];
+unsigned char flash_loaded = 0;
+
+/**
+ * @brief Load flash content from file given by SIM_FLASH (erased if not set)
+ */
+void flash_load() {
+
+    memset(flash_data, 0xff, sizeof (flash_data));
+    flash_loaded = 1;
+
+    char * filename = getenv("SIM_FLASH");
+    if (!filename) return;
+
+    FILE * f = fopen(filename, "rb");
+    if (!f) return;
+    if (fread(flash_data, 1, sizeof (flash_data), f) != sizeof (flash_data)) {
+        memset(flash_data, 0xff, sizeof (flash_data));
+    }
+    fclose(f);
+}
+
+/**
+ * @brief Read low byte of given program memory word
+ * @param address Program memory address
+ * @return Low byte of program memory word
+ */
+unsigned char flash_read(unsigned short address) {
+
+    if (!flash_loaded) flash_load();
+
+    if ((address < FLASH_SIM_ADDRESS) || (address >= FLASH_SIM_ADDRESS + FLASH_SIM_SIZE)) return 0xff;
+    return flash_data[address - FLASH_SIM_ADDRESS];
+}
+
+/**
+ * @brief Erase and write one program memory row
+ * @param address Start address of row (must be row aligned)
+ * @param data Data to write
+ * @param length Count of bytes to write, rest of row is filled with 0xff
+ */
+void flash_writeRow(unsigned short address, unsigned char * data, unsigned char length) {
+
+    if (!flash_loaded) flash_load();
+
+    if ((address < FLASH_SIM_ADDRESS) || (address + FLASH_ROWSIZE > FLASH_SIM_ADDRESS + FLASH_SIM_SIZE)) return;
+
+    // like the target, never write beyond the row
+    if (length > FLASH_ROWSIZE) length = FLASH_ROWSIZE;
+
+    unsigned char * row = &flash_data[address - FLASH_SIM_ADDRESS];
+    memset(row, 0xff, FLASH_ROWSIZE);
+    memcpy(row, data, length);
+
+    char * filename = getenv("SIM_FLASH");
+    if (!filename) return;
+
+    FILE * f = fopen(filename, "wb");
+    if (!f) return;
+    fwrite(flash_data, 1, sizeof (flash_data), f);
+    fclose(f);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file host.h
+ *
+ * @brief This file contains the hardware abstraction of the native host
+ *        build for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#ifndef HOST_H
+#define	HOST_H
+
+#include <stdint.h>
+
+// XC8 provides a native 24 bit type, the host uses 32 bit
+typedef int32_t int24_t;
+
+#define interrupt
+#define HAL_AT(address)
+#define HAL_RESET() sim_reset()
+
+/* Registers used outside of the peripheral drivers */
+extern volatile unsigned char OSCCON, ACTCON, ANSELA, ANSELC, TRISA, TRISC;
+extern volatile unsigned char PEIE, GIE;
+extern volatile unsigned char TMR2IE, TMR2IF, SSP1IE, SSP1IF, BCL1IE, BCL1IF, TXIE, TXIF, USBIE, USBIF;
+
+typedef struct {
+    unsigned HFIOFR : 1;
+    unsigned PLLRDY : 1;
+} OSCSTATbits_t;
+extern volatile OSCSTATbits_t OSCSTATbits;
+
+typedef struct {
+    unsigned RA3 : 1;
+} PORTAbits_t;
+extern volatile PORTAbits_t PORTAbits;
+
+void isr(void);
+
+void sim_poll();
+void sim_reset();
+unsigned char sim_i2cTransfer(unsigned char address, unsigned char * data, unsigned char writelength, unsigned char readlength);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file i2c.c
+ *
+ * @brief This file contains the simulated I2C bus of the native host build
+ *        for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "clock.h"
+#include "i2c.h"
+
+unsigned short i2c_recoveries = 0;
+I2C_TRANSACTION * i2c_queue[I2C_QUEUE_SIZE];
+unsigned char i2c_queue_writepos = 0;
+unsigned char i2c_queue_readpos = 0;
+
+/**
+ * @brief Initialize I2C unit
+ */
+void i2c_init() {
+}
+
+/**
+ * @brief Set I2C bus clock
+ * @param speed Bus clock preset (I2C_SPEED_xxx)
+ * @retval 1 Successful
+ * @retval 0 Invalid preset
+ */
+unsigned char i2c_setSpeed(unsigned char speed) {
+    return speed < I2C_SPEED_NROF;
+}
+
+/**
+ * @brief Put transaction into queue
+ * @param transaction Transaction to execute
+ * @retval 1 Transaction queued, status is I2C_STATUS_PENDING
+ * @retval 0 Queue full
+ */
+unsigned char i2c_enqueue(I2C_TRANSACTION * transaction) {
+
+    unsigned char nextpos = (i2c_queue_writepos + 1) % I2C_QUEUE_SIZE;
+    if (nextpos == i2c_queue_readpos) return 0;
+
+    transaction->status = I2C_STATUS_PENDING;
+    i2c_queue[i2c_queue_writepos] = transaction;
+    i2c_queue_writepos = nextpos;
+
+    return 1;
+}
+
+/**
+ * @brief Get result of finished transaction and release it
+ * @param transaction Transaction
+ * @retval I2C_STATUS_PENDING Transaction still in progress
+ * @retval I2C_STATUS_DONE Transaction finished successfully
+ * @retval I2C_STATUS_ERROR Transaction failed
+ */
+unsigned char i2c_finish(I2C_TRANSACTION * transaction) {
+
+    unsigned char status = transaction->status;
+    if (status != I2C_STATUS_PENDING) transaction->status = I2C_STATUS_IDLE;
+
+    return status;
+}
+
+/**
+ * @brief Execute queued transactions on the simulated devices
+ *
+ * One transaction per call, so results show up one main loop iteration
+ * later like on the target.
+ */
+void i2c_process() {
+
+    // main loop hook of the simulation
+    sim_poll();
+
+    if (i2c_queue_readpos == i2c_queue_writepos) return;
+
+    I2C_TRANSACTION * t = i2c_queue[i2c_queue_readpos];
+    i2c_queue_readpos = (i2c_queue_readpos + 1) % I2C_QUEUE_SIZE;
+
+    if (sim_i2cTransfer(t->address, t->data, t->writelength, t->readlength)) {
+        t->status = I2C_STATUS_DONE;
+    } else {
+        t->status = I2C_STATUS_ERROR;
+    }
+}
+
+/**
+ * @brief I2C interrupt routine
+ */
+inline void i2c_isr() {
+}
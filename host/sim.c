@@ -0,0 +1,246 @@
+/**
+ * @file sim.c
+ *
+ * @brief This file contains the time base and device models of the native
+ *        host build for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "thermosera.h"
+#include "mcp3424.h"
+#include "mcp9800.h"
+
+/*
+ * Environment variables:
+ *   SIM_EMF      thermoelectric voltages at MCP3424 inputs 1..4 in uV,
+ *                comma separated (default 4096,8138,12209,16397)
+ *   SIM_AMBIENT  MCP9800 temperature in 0.1 degree (default 250)
+ *   SIM_SPEEDUP  time base factor relative to real time (default 1)
+ *   SIM_TICKS    exit after given count of 10 ms ticks (default: run forever)
+ *   SIM_FLASH    file to keep the log rows and HEF in (see flash.c)
+ */
+
+#define SIM_TICK_US 10000
+
+volatile unsigned char OSCCON, ACTCON, ANSELA, ANSELC, TRISA, TRISC;
+volatile unsigned char PEIE, GIE;
+volatile unsigned char TMR2IE, TMR2IF, SSP1IE, SSP1IF, BCL1IE, BCL1IF, TXIE, TXIF, USBIE, USBIF;
+volatile OSCSTATbits_t OSCSTATbits = {1, 1};
+volatile PORTAbits_t PORTAbits = {1};
+
+unsigned char sim_initialized = 0;
+unsigned long sim_speedup = 1;
+unsigned long sim_maxticks = 0;
+unsigned long sim_ticks = 0;
+struct timespec sim_start;
+
+// conversion time per resolution in us (240, 60, 15, 3.75 SPS)
+const unsigned long sim_mcp3424_convtime[] = {4167, 16667, 66667, 266667};
+long sim_mcp3424_emf[4] = {4096, 8138, 12209, 16397};
+unsigned char sim_mcp3424_config = 0x90;
+unsigned long long sim_mcp3424_start = 0;
+unsigned long long sim_mcp3424_lastread = 0;
+unsigned char sim_mcp3424_unread = 0;
+
+long sim_mcp9800_ambient = 250;
+unsigned char sim_mcp9800_pointer = MCP9800_REG_DATA;
+unsigned char sim_mcp9800_config = 0;
+
+/**
+ * @brief Read simulation parameters from environment
+ */
+void sim_init() {
+
+    char * s;
+
+    clock_gettime(CLOCK_MONOTONIC, &sim_start);
+
+    if ((s = getenv("SIM_EMF"))) {
+        sscanf(s, "%ld,%ld,%ld,%ld", &sim_mcp3424_emf[0], &sim_mcp3424_emf[1], &sim_mcp3424_emf[2], &sim_mcp3424_emf[3]);
+    }
+    if ((s = getenv("SIM_AMBIENT"))) sim_mcp9800_ambient = atol(s);
+    if ((s = getenv("SIM_SPEEDUP"))) sim_speedup = atol(s);
+    if ((s = getenv("SIM_TICKS"))) sim_maxticks = atol(s);
+
+    sim_initialized = 1;
+}
+
+/**
+ * @brief Get simulated time
+ * @return Time since start in us
+ */
+unsigned long long sim_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned long long us = (now.tv_sec - sim_start.tv_sec) * 1000000ULL;
+    us += now.tv_nsec / 1000;
+    us -= sim_start.tv_nsec / 1000;
+    return us * sim_speedup;
+}
+
+/**
+ * @brief Generate pending timer interrupts and the USB interrupt
+ *
+ * Called from i2c_process() once per main loop iteration.
+ */
+void sim_poll() {
+
+    if (!sim_initialized) sim_init();
+
+    USBIF = 1;
+    if (GIE) isr();
+
+    unsigned long long ticks = sim_now() / SIM_TICK_US;
+    while (sim_ticks < ticks) {
+        sim_ticks++;
+        TMR2IF = 1;
+        if (GIE) isr();
+
+        if (sim_maxticks && (sim_ticks >= sim_maxticks)) {
+            fflush(stdout);
+            exit(0);
+        }
+    }
+}
+
+/**
+ * @brief Reset of the target, leaves the simulation
+ */
+void sim_reset() {
+    exit(0);
+}
+
+/**
+ * @brief MCP3424 model
+ *
+ * A write to the configuration register starts a conversion. Reads return
+ * the output code followed by the configuration register, /RDY is cleared
+ * once per finished conversion.
+ *
+ * @param data Transfer buffer
+ * @param writelength Count of bytes written to device
+ * @param readlength Count of bytes read from device
+ */
+void sim_mcp3424(unsigned char * data, unsigned char writelength, unsigned char readlength) {
+
+    unsigned long long now = sim_now();
+
+    if (writelength) {
+        sim_mcp3424_config = data[0];
+        sim_mcp3424_start = now;
+        sim_mcp3424_lastread = now;
+        sim_mcp3424_unread = 0;
+    }
+
+    if (!readlength) return;
+
+    unsigned char resolution = (sim_mcp3424_config & MCP3424_CONFIG_RESOLUTION_MASK) >> MCP3424_CONFIG_RESOLUTION_SHIFT;
+    unsigned char gain = sim_mcp3424_config & MCP3424_CONFIG_GAIN_MASK;
+    unsigned char channel = (sim_mcp3424_config >> MCP3424_CONFIG_CHANNEL_SHIFT) & 0x03;
+    unsigned long convtime = sim_mcp3424_convtime[resolution];
+
+    if (sim_mcp3424_config & MCP3424_CONFIG_CONTINUOUS) {
+        // new result at the end of each conversion period
+        if ((now - sim_mcp3424_start) / convtime > (sim_mcp3424_lastread - sim_mcp3424_start) / convtime) {
+            sim_mcp3424_unread = 1;
+        }
+    } else if ((sim_mcp3424_config & MCP3424_CONFIG_RDY) && (now - sim_mcp3424_start >= convtime)) {
+        // one-shot conversion finished
+        sim_mcp3424_config &= ~MCP3424_CONFIG_RDY;
+        sim_mcp3424_unread = 1;
+    }
+
+    // 12 bit: 1mV LSB, 4 times finer per resolution step
+    long long code = (long long) sim_mcp3424_emf[channel] << ((resolution << 1) + gain);
+    code /= 1000;
+    long max = (1L << (11 + (resolution << 1))) - 1;
+    if (code > max) code = max;
+    if (code < -max - 1) code = -max - 1;
+
+    unsigned char count = 2;
+    if (resolution == MCP3424_RESOLUTION_18BIT) count = 3;
+
+    unsigned char config = sim_mcp3424_config | MCP3424_CONFIG_RDY;
+    if (sim_mcp3424_unread) config &= ~MCP3424_CONFIG_RDY;
+
+    unsigned char i;
+    for (i = 0; i < readlength; i++) {
+        if (i < count) data[i] = code >> ((count - 1 - i) << 3);
+        else data[i] = config;
+    }
+
+    if (sim_mcp3424_unread) {
+        sim_mcp3424_unread = 0;
+        sim_mcp3424_lastread = now;
+    }
+}
+
+/**
+ * @brief MCP9800 model
+ *
+ * The first written byte selects the register, a second byte is written into
+ * the configuration register. Reads return the selected register.
+ *
+ * @param data Transfer buffer
+ * @param writelength Count of bytes written to device
+ * @param readlength Count of bytes read from device
+ */
+void sim_mcp9800(unsigned char * data, unsigned char writelength, unsigned char readlength) {
+
+    if (writelength >= 1) sim_mcp9800_pointer = data[0];
+    if ((writelength >= 2) && (sim_mcp9800_pointer == MCP9800_REG_CONFIG)) sim_mcp9800_config = data[1];
+
+    if (!readlength) return;
+
+    if (sim_mcp9800_pointer == MCP9800_REG_CONFIG) {
+        data[0] = sim_mcp9800_config;
+        return;
+    }
+
+    // 1/256 degree, left aligned
+    short value = sim_mcp9800_ambient * 256 / 10;
+    data[0] = value >> 8;
+    if (readlength > 1) data[1] = value;
+}
+
+/**
+ * @brief Execute I2C transfer on simulated device
+ * @param address Device address (write address)
+ * @param data Transfer buffer, received bytes overwrite it from index 0
+ * @param writelength Count of bytes to write
+ * @param readlength Count of bytes to read
+ * @retval 1 Device acknowledged
+ * @retval 0 No device with given address
+ */
+unsigned char sim_i2cTransfer(unsigned char address, unsigned char * data, unsigned char writelength, unsigned char readlength) {
+
+    if (address == MCP3424_I2C_ADDRESS) {
+        sim_mcp3424(data, writelength, readlength);
+        return 1;
+    }
+
+    if (address == MCP9800_I2C_ADDRESS) {
+        sim_mcp9800(data, writelength, readlength);
+        return 1;
+    }
+
+    return 0;
+}
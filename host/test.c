@@ -0,0 +1,336 @@
+/**
+ * @file test.c
+ *
+ * @brief This file contains the unit tests of the native host build for the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "thermosera.h"
+#include "usb_cdc.h"
+#include "thermocouple.h"
+#include "history.h"
+#include "filter.h"
+
+/* Firmware internals under test */
+void print_degree(int24_t val, unsigned char decimals);
+extern unsigned char txbuffer[TXBUFFER_SIZE];
+extern volatile unsigned char txbuffer_writepos;
+extern volatile unsigned char txbuffer_readpos;
+extern const THERMOCOUPLE_POINT * const thermocouple_tables[THERMOCOUPLE_TYPE_NROF];
+extern const unsigned char thermocouple_tablesizes[THERMOCOUPLE_TYPE_NROF];
+extern volatile unsigned long clock_millis;
+
+unsigned short test_count = 0;
+unsigned short test_failed = 0;
+
+#define TEST_CHECK(cond, ...) do { \
+        test_count++; \
+        if (!(cond)) { \
+            test_failed++; \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+/**
+ * @brief Take pending characters out of the USB send buffer
+ *
+ * @param s Buffer for the null-terminated characters
+ */
+void test_takeOutput(char * s) {
+    usb_txCommit();
+    while (txbuffer_readpos != txbuffer_writepos) {
+        *s++ = txbuffer[txbuffer_readpos];
+        txbuffer_readpos = (txbuffer_readpos + 1) % TXBUFFER_SIZE;
+    }
+    *s = 0;
+}
+
+/**
+ * @brief Decimal formatter, right aligned and rounded
+ */
+void test_printDegree() {
+
+    static const struct {
+        int24_t val;
+        unsigned char decimals;
+        const char * expected;
+    } cases[] = {
+        {0, 1, "    0.0"},
+        {5, 1, "    0.5"},
+        {-5, 1, "   -0.5"},
+        {253, 1, "   25.3"},
+        {-1999, 1, " -199.9"},
+        {13720, 1, " 1372.0"},
+        {65530, 1, " 6553.0"},
+        {0, 0, "      0"},
+        {4, 0, "      0"},
+        {-4, 0, "      0"},
+        {245, 0, "     25"},
+        {-245, 0, "    -25"},
+        {244, 0, "     24"},
+        {-2000, 0, "   -200"},
+        {13725, 0, "   1373"},
+    };
+
+    char s[TXBUFFER_SIZE];
+    unsigned char i;
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        print_degree(cases[i].val, cases[i].decimals);
+        test_takeOutput(s);
+        TEST_CHECK(strcmp(s, cases[i].expected) == 0,
+                "print_degree(%d, %d) = \"%s\", expected \"%s\"",
+                cases[i].val, cases[i].decimals, s, cases[i].expected);
+    }
+}
+
+/**
+ * @brief Thermocouple linearization against table points and reference values
+ */
+void test_thermocouple() {
+
+    unsigned char type;
+    for (type = 0; type < THERMOCOUPLE_TYPE_NROF; type++) {
+
+        const THERMOCOUPLE_POINT * table = thermocouple_tables[type];
+        unsigned char size = thermocouple_tablesizes[type];
+
+        // exact at the table points, monotonic in between (the emf of type B
+        // isn't unique below 50 degree, these points are only checked one way)
+        unsigned char i;
+        for (i = 0; i < size; i++) {
+            if (((i == 0) || (table[i - 1].emf < table[i].emf)) &&
+                    ((i == size - 1) || (table[i].emf < table[i + 1].emf))) {
+                TEST_CHECK(thermocouple_getTemperature(type, table[i].emf) == table[i].temperature,
+                        "type %c point %d: temperature of %d uV", THERMOCOUPLE_TYPE_LETTERS[type], i, table[i].emf);
+            }
+            TEST_CHECK(thermocouple_getEmf(type, table[i].temperature) == table[i].emf,
+                    "type %c point %d: emf of %d", THERMOCOUPLE_TYPE_LETTERS[type], i, table[i].temperature);
+        }
+
+        int24_t emf;
+        int24_t last = thermocouple_getTemperature(type, table[0].emf);
+        for (emf = table[0].emf; emf <= table[size - 1].emf; emf += 7) {
+            int24_t t = thermocouple_getTemperature(type, emf);
+            TEST_CHECK(t >= last, "type %c: not monotonic at %d uV", THERMOCOUPLE_TYPE_LETTERS[type], emf);
+            last = t;
+        }
+
+        // limited outside of the table range
+        TEST_CHECK(thermocouple_getTemperature(type, table[0].emf - 1000) == table[0].temperature,
+                "type %c: below range", THERMOCOUPLE_TYPE_LETTERS[type]);
+        TEST_CHECK(thermocouple_getTemperature(type, table[size - 1].emf + 1000) == table[size - 1].temperature,
+                "type %c: above range", THERMOCOUPLE_TYPE_LETTERS[type]);
+    }
+
+    // NIST ITS-90 reference values, 0.5 degree tolerance
+    static const struct {
+        unsigned char type;
+        int24_t emf;
+        int24_t temperature;
+    } references[] = {
+        {THERMOCOUPLE_TYPE_K, 4096, 1000},
+        {THERMOCOUPLE_TYPE_K, 41276, 10000},
+        {THERMOCOUPLE_TYPE_K, -3554, -1000},
+        {THERMOCOUPLE_TYPE_J, 5269, 1000},
+        {THERMOCOUPLE_TYPE_T, 4279, 1000},
+        {THERMOCOUPLE_TYPE_E, 6319, 1000},
+        {THERMOCOUPLE_TYPE_N, 2774, 1000},
+        {THERMOCOUPLE_TYPE_R, 647, 1000},
+        {THERMOCOUPLE_TYPE_S, 646, 1000},
+        {THERMOCOUPLE_TYPE_B, 4834, 10000},
+    };
+
+    unsigned char i;
+    for (i = 0; i < sizeof (references) / sizeof (references[0]); i++) {
+        int24_t t = thermocouple_getTemperature(references[i].type, references[i].emf);
+        int24_t error = t - references[i].temperature;
+        TEST_CHECK((error >= -5) && (error <= 5), "type %c: %d uV = %d, expected %d",
+                THERMOCOUPLE_TYPE_LETTERS[references[i].type], references[i].emf, t, references[i].temperature);
+    }
+}
+
+/**
+ * @brief Decode block and compare with expected records
+ *
+ * @param block Block to decode
+ * @param times Expected time of each record
+ * @param values Expected values of each record (CHANNELS_NROF + 1 per record)
+ * @param count Expected count of records
+ */
+void test_decodeBlock(unsigned char * block, unsigned short * times, signed short * values, unsigned char count) {
+
+    unsigned char mask = block[HISTORY_HEADER_MASK] & HISTORY_MASK_VALUES;
+    unsigned char length = block[HISTORY_HEADER_LENGTH];
+    unsigned char pos = HISTORY_HEADER_SIZE;
+    signed short last[CHANNELS_NROF + 1];
+    unsigned char record = 0;
+
+    while (pos < length) {
+
+        TEST_CHECK(record < count, "block holds more than %d records", count);
+        if (record >= count) return;
+
+        unsigned short time = block[pos++];
+        if (time == HISTORY_TIME_ESCAPE) {
+            time = (block[pos] << 8) | block[pos + 1];
+            pos += 2;
+        }
+        TEST_CHECK(time == times[record], "record %d: time %d, expected %d", record, time, times[record]);
+
+        unsigned char i;
+        for (i = 0; i <= CHANNELS_NROF; i++) {
+            if (!(mask & (1 << i))) continue;
+
+            signed short v;
+            if (record && (block[pos] != HISTORY_DELTA_ESCAPE)) {
+                v = last[i] + (signed char) block[pos++];
+            } else {
+                if (record) pos++;
+                v = (signed short) ((block[pos] << 8) | block[pos + 1]);
+                pos += 2;
+            }
+            TEST_CHECK(v == values[record * (CHANNELS_NROF + 1) + i],
+                    "record %d value %d: %d, expected %d", record, i, v, values[record * (CHANNELS_NROF + 1) + i]);
+            last[i] = v;
+        }
+        record++;
+    }
+
+    TEST_CHECK(pos == length, "record exceeds block length");
+    TEST_CHECK(record == count, "block holds %d records, expected %d", record, count);
+}
+
+/**
+ * @brief History codec round trip with differences, escapes and full block
+ */
+void test_historyCodec() {
+
+    unsigned char block[HISTORY_BLOCKSIZE];
+    signed short last[CHANNELS_NROF + 1];
+    unsigned char mask = 0x05 | FRAME_MASK_AMBIENT;
+
+    // channel 1, channel 3 (small, large and invalid steps) and ambient,
+    // the 500 ticks of a 5 s scan interval need the time escape
+    unsigned short times[] = {0, 25, 254, 500, 1};
+    signed short values[][CHANNELS_NROF + 1] = {
+        {1000, 0, -1999, 0, 250},
+        {1127, 0, -2126, 0, 250},
+        {1128, 0, -2125, 0, 251},
+        {-32000, 0, HISTORY_VALUE_INVALID, 0, 124},
+        {-31999, 0, -32767, 0, 125},
+    };
+
+    memset(block, 0, sizeof (block));
+    TEST_CHECK(!history_append(block, mask, times[0], values[0], last), "append to unused block");
+
+    history_startBlock(block, 7, mask, times[0], values[0], last);
+    TEST_CHECK(block[HISTORY_HEADER_SEQUENCE] == 7, "sequence %d", block[HISTORY_HEADER_SEQUENCE]);
+    TEST_CHECK(block[HISTORY_HEADER_MASK] == mask, "mask %02x", block[HISTORY_HEADER_MASK]);
+    TEST_CHECK(block[HISTORY_HEADER_LENGTH] == HISTORY_HEADER_SIZE + 7, "length of first record %d", block[HISTORY_HEADER_LENGTH]);
+
+    // different mask starts a new block
+    TEST_CHECK(!history_append(block, mask & ~FRAME_MASK_AMBIENT, times[1], values[1], last), "append with other mask");
+
+    unsigned char i;
+    for (i = 1; i < 5; i++) {
+        TEST_CHECK(history_append(block, mask, times[i], values[i], last), "append record %d", i);
+    }
+    TEST_CHECK(block[HISTORY_HEADER_LENGTH] == HISTORY_BLOCKSIZE, "length of full block %d", block[HISTORY_HEADER_LENGTH]);
+    test_decodeBlock(block, times, &values[0][0], 5);
+
+    // full block starts a new block
+    TEST_CHECK(!history_append(block, mask, 1, values[4], last), "append to full block");
+    TEST_CHECK(block[HISTORY_HEADER_LENGTH] == HISTORY_BLOCKSIZE, "length changed by refused record");
+
+    // invalid values are kept
+    int24_t raw[CHANNELS_NROF + 1] = {VALUE_INVALID_BINARY, -1, 0, 13720, 250};
+    signed short converted[CHANNELS_NROF + 1];
+    history_convert(converted, raw);
+    TEST_CHECK(converted[0] == HISTORY_VALUE_INVALID, "invalid value converted to %d", converted[0]);
+    TEST_CHECK((converted[1] == -1) && (converted[3] == 13720), "values converted to %d, %d", converted[1], converted[3]);
+
+    // 30 scans of 100 ms with 4 records per block, the oldest 8 are overwritten
+    int24_t scan[CHANNELS_NROF + 1] = {1000, 1001, 1002, 1003, 250};
+    clock_millis = 1000;
+    history_add(0x0F | FRAME_MASK_AMBIENT, scan);
+    TEST_CHECK(history_getSpan() == 0, "span of single record %lu", history_getSpan());
+    for (i = 1; i < 30; i++) {
+        clock_millis += 100;
+        history_add(0x0F | FRAME_MASK_AMBIENT, scan);
+    }
+    TEST_CHECK(history_getSpan() == 2100, "span of history %lu", history_getSpan());
+}
+
+/**
+ * @brief Filters of the ADC results
+ */
+void test_filter() {
+
+    static const struct {
+        unsigned char type;
+        unsigned char param;
+        int24_t input[6];
+        int24_t expected[6];
+    } cases[] = {
+        {FILTER_TYPE_NONE, 0, {100, -5, 70000, 0, 1, 2}, {100, -5, 70000, 0, 1, 2}},
+        {FILTER_TYPE_BOXCAR, 3, {100, 200, 300, 400, 500, 600}, {100, 150, 200, 300, 400, 500}},
+        {FILTER_TYPE_BOXCAR, 2, {-100000, -100010, -99990, -99990, 0, 10}, {-100000, -100005, -100000, -99990, -49995, 5}},
+        {FILTER_TYPE_BOXCAR, 3, {0, 8000, 16000, 24000, 32000, 40000}, {0, 4000, 8000, 16000, 24000, 32000}},
+        {FILTER_TYPE_IIR, 1, {0, 1000, 1000, 1000, 1000, 1000}, {0, 500, 750, 875, 938, 969}},
+        {FILTER_TYPE_MEDIAN, 3, {100, 5000, 110, 120, 120, -3000}, {100, 5000, 110, 120, 120, 120}},
+        {FILTER_TYPE_MEDIAN, 5, {10, 12, 11, 90, 11, -80}, {10, 12, 11, 12, 11, 11}},
+        {FILTER_TYPE_MEDIAN, 3, {1000, 1000, 1000, 200000, 1000, -200000}, {1000, 1000, 1000, 1000, 1000, 1000}},
+    };
+
+    unsigned char i;
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        TEST_CHECK(filter_set(0, cases[i].type, cases[i].param), "filter %d/%d refused", cases[i].type, cases[i].param);
+
+        unsigned char j;
+        for (j = 0; j < 6; j++) {
+            int24_t y = filter_apply(0, cases[i].input[j]);
+            TEST_CHECK(y == cases[i].expected[j], "filter %d/%d sample %d: %d, expected %d",
+                    cases[i].type, cases[i].param, j, y, cases[i].expected[j]);
+        }
+    }
+
+    TEST_CHECK(!filter_set(0, FILTER_TYPE_BOXCAR, FILTER_SAMPLES + 1), "boxcar too long");
+    TEST_CHECK(!filter_set(0, FILTER_TYPE_MEDIAN, 4), "median of 4");
+    filter_set(0, FILTER_TYPE_NONE, 0);
+}
+
+/**
+ * @brief Run all unit tests
+ *
+ * @return 0 if all tests passed
+ */
+int main() {
+
+    test_printDegree();
+    test_thermocouple();
+    test_historyCodec();
+    test_filter();
+
+    printf("%d checks, %d failed\n", test_count, test_failed);
+    return test_failed ? 1 : 0;
+}
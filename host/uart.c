@@ -0,0 +1,81 @@
+/**
+ * @file uart.c
+ *
+ * @brief This file contains the simulated UART of the native host build
+ *        for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "uart.h"
+
+unsigned short uart_txoverflow = 0;
+unsigned long uart_txcount = 0;
+
+/**
+ * @brief Initialize UART
+ */
+void uart_init() {
+}
+
+/**
+ * @brief Set UART baudrate
+ * @param baudrate Baudrate index (UART_BAUDRATE_xxx)
+ * @retval 1 Successful
+ * @retval 0 Invalid baudrate index
+ */
+unsigned char uart_setBaudrate(unsigned char baudrate) {
+    return baudrate < UART_BAUDRATE_NROF;
+}
+
+/**
+ * @brief Apply pending baudrate change, nothing to do on the host
+ */
+void uart_process() {
+}
+
+/**
+ * @brief Put character into UART send buffer, output is discarded
+ * @param ch Character to send
+ */
+void uart_putch(unsigned char ch) {
+    uart_txcount++;
+}
+
+/**
+ * @brief UART transmit interrupt routine
+ */
+inline void uart_txisr() {
+    TXIE = 0;
+}
+
+/**
+ * @brief Read character from UART
+ * @return Character received over UART
+ */
+unsigned char uart_getch() {
+    return 0;
+}
+
+/**
+ * @brief Determine if character from UART available
+ * @retval 0 Nothing is received on the host
+ */
+unsigned char uart_chReceived() {
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file usb_cdc.c
+ *
+ * @brief This file contains the simulated USB CDC endpoints of the native
+ *        host build for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include "thermosera.h"
+#include "usb_cdc.h"
+
+/*
+ * The IN endpoint is written to stdout, the OUT endpoint is filled from
+ * stdin. Packets have the same size as on the target.
+ */
+
+unsigned char ep1in_buffer[EP_BULK_BUFFERSIZE];
+unsigned char ep3out_buffer[EP_BULK_BUFFERSIZE];
+unsigned char ep3out_cnt = 0;
+unsigned char usb_eof = 0;
+unsigned char usb_suspended = 0;
+
+unsigned char txbuffer[TXBUFFER_SIZE];
+unsigned char txbuffer_fillpos = 0;
+volatile unsigned char txbuffer_writepos = 0;
+volatile unsigned char txbuffer_readpos = 0;
+unsigned short usb_txdropped = 0;
+unsigned char usb_txhighwater = 0;
+
+/**
+ * @brief Initialize USB stack
+ */
+void usb_init() {
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+    USBIE = 1;
+}
+
+/**
+ * @brief Shutdown USB
+ */
+void usb_shutdown() {
+    USBIE = 0;
+}
+
+/**
+ * @brief Put given character into send buffer
+ *
+ * @param ch Character to send
+ */
+void usb_putch(unsigned char ch) {
+
+    unsigned char nextpos = (txbuffer_fillpos + 1) % TXBUFFER_SIZE;
+    if (nextpos == txbuffer_readpos) {
+        // overflow!
+        return;
+    }
+
+    txbuffer[txbuffer_fillpos] = ch;
+    txbuffer_fillpos = nextpos;
+
+}
+
+/**
+ * @brief Release the characters put into the send buffer since last commit
+ *
+ * Called after each complete frame or reply, so a packet never ends in
+ * the middle of one while the rest is still being written.
+ */
+void usb_txCommit() {
+    txbuffer_writepos = txbuffer_fillpos;
+}
+
+/**
+ * @brief Determine if the port is opened by the host, stdout always is
+ *
+ * @retval 1 port opened
+ */
+unsigned char usb_isOpen() {
+    return 1;
+}
+
+/**
+ * @brief Determine if the host has suspended the bus, the end of stdin does
+ *
+ * @retval 1 stdin closed since last call
+ * @retval 0 no new suspend
+ */
+unsigned char usb_checkSuspend() {
+    if (!usb_eof || usb_suspended) return 0;
+    usb_suspended = 1;
+    return 1;
+}
+
+/**
+ * @brief Get free space in send buffer
+ *
+ * @return Count of characters which can be put into send buffer
+ */
+unsigned char usb_txFree() {
+    return (TXBUFFER_SIZE - 1 + txbuffer_readpos - txbuffer_fillpos) % TXBUFFER_SIZE;
+}
+
+/**
+ * @brief Reserve space in send buffer for a frame
+ *
+ * @param count Count of characters to send
+ * @retval 1 frame fits into send buffer
+ * @retval 0 send buffer too full
+ */
+unsigned char usb_txReserve(unsigned char count) {
+
+    unsigned char free = usb_txFree();
+    if (count > free) {
+        usb_txdropped++;
+        return 0;
+    }
+
+    unsigned char used = TXBUFFER_SIZE - 1 - free + count;
+    if (used > usb_txhighwater) usb_txhighwater = used;
+    return 1;
+}
+
+/**
+ * @brief Put given nullterminated string into send buffer
+ *
+ * @param s String to send
+ */
+void usb_putstr(char * s) {
+   while (*s) {
+     usb_putch((unsigned char) *s);
+     s++;
+   }
+}
+
+/**
+ * @brief Send one packet of pending data
+ */
+void usb_txprocess() {
+
+    unsigned char count = (TXBUFFER_SIZE + txbuffer_writepos - txbuffer_readpos) % TXBUFFER_SIZE;
+    if (count == 0) return;
+    if (count > EP_BULK_BUFFERSIZE) count = EP_BULK_BUFFERSIZE;
+
+    unsigned char readpos = txbuffer_readpos;
+
+    unsigned char i;
+    for (i = 0; i < count; i++) {
+        ep1in_buffer[i] = txbuffer[readpos];
+        readpos ++;
+        if (readpos == TXBUFFER_SIZE) readpos = 0;
+    }
+
+    if (write(STDOUT_FILENO, ep1in_buffer, count) != count) return;
+    txbuffer_readpos = readpos;
+}
+
+/**
+ * @brief USB interrupt routine, raised by sim_poll() once per main loop
+ */
+inline void usb_isr() {
+
+    usb_txprocess();
+
+    // receive next packet if the last one is consumed
+    if ((ep3out_cnt == 0) && !usb_eof) {
+        ssize_t count = read(STDIN_FILENO, ep3out_buffer, EP_BULK_BUFFERSIZE);
+        if (count > 0) ep3out_cnt = count;
+        else if (count == 0) usb_eof = 1;
+    }
+
+    USBIF = 0;
+}
+
+/**
+ * @brief Get next received block
+ *
+ * @param data Set to begin of received data
+ * @return Count of received bytes, 0 if nothing received
+ */
+unsigned char usb_getBlock(char ** data) {
+    *data = (char *) ep3out_buffer;
+    return ep3out_cnt;
+}
+
+/**
+ * @brief Hand buffer of last received block back for the next read
+ */
+void usb_releaseBlock() {
+    ep3out_cnt = 0;
+}
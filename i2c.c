@@ -22,27 +22,38 @@
  * 
  */
 
-#include <xc.h>
+#include "hal.h"
 #include "clock.h"
 #include "i2c.h"
 
-#define I2C_BRG ((_XTAL_FREQ / (4 * I2C_SCL)) - 1)
+#define I2C_BRG(scl) ((_XTAL_FREQ / (4 * (scl))) - 1)
 
-/**
- * @brief Wait for interrupt flag to be set
- * @retval 1 Flag cleared
- * @retval 0 Timeout
- */
-unsigned char waitForIF() {
-    unsigned char starttime = clock_tickerSlow;
-    while (!SSP1IF) {
-        if (clock_diff(starttime) > 5) {
-            return 0;
-        }
-	}
-	SSP1IF = 0;
-    return 1;
-}
+// baud rate generator values for bus clock presets
+const unsigned char i2c_brgvalues[I2C_SPEED_NROF] = {
+    I2C_BRG(50000),
+    I2C_BRG(100000),
+    I2C_BRG(400000)
+};
+
+// transaction timeout in clock ticks; the longest transaction (6 bytes incl.
+// address) takes 1.2 ms at 50 kHz, so the tick resolution dominates
+const unsigned char i2c_timeouts[I2C_SPEED_NROF] = {
+    4,
+    2,
+    1
+};
+
+unsigned char i2c_timeout;
+unsigned short i2c_recoveries = 0;
+I2C_TRANSACTION * i2c_queue[I2C_QUEUE_SIZE];
+volatile unsigned char i2c_queue_writepos = 0;
+volatile unsigned char i2c_queue_readpos = 0;
+
+I2C_TRANSACTION * i2c_current;
+volatile unsigned char i2c_state = I2C_STATE_IDLE;
+unsigned char i2c_pos;
+unsigned char i2c_result;
+volatile unsigned char i2c_laststamp;
 
 /**
  * @brief Initialize I2C unit
@@ -50,7 +61,7 @@ unsigned char waitForIF() {
 void i2c_init() {
 
 	// set baud rate generation
-	SSPADD = I2C_BRG;
+	i2c_setSpeed(I2C_SPEED_50KHZ);
 
 	// set I2C master mode
 	SSPCON1 = 0b00001000;
@@ -58,96 +69,253 @@ void i2c_init() {
 	// enable ssp unit
 	SSPCON1bits.SSPEN = 1;
 
+	// enable interrupts
+	SSP1IF = 0;
+	BCL1IF = 0;
+	SSP1IE = 1;
+	BCL1IE = 1;
 }
 
 /**
- * @brief Send start condition
+ * @brief Set I2C bus clock
+ *
+ * Waits until all queued transactions are finished.
+ *
+ * @param speed Bus clock preset (I2C_SPEED_xxx)
  * @retval 1 Successful
- * @retval 0 Timeout
+ * @retval 0 Invalid preset
  */
-unsigned char i2c_start() {
+unsigned char i2c_setSpeed(unsigned char speed) {
+
+    if (speed >= I2C_SPEED_NROF) return 0;
 
-	// set start condition
-	SSPCON2bits.SEN = 1;
+    while ((i2c_state != I2C_STATE_IDLE) || (i2c_queue_readpos != i2c_queue_writepos)) {
+        i2c_process();
+    }
 
-	return waitForIF();
+    SSPADD = i2c_brgvalues[speed];
+    i2c_timeout = i2c_timeouts[speed];
+
+    // slew rate control for 400 kHz only
+    SSPSTATbits.SMP = (speed != I2C_SPEED_400KHZ);
+
+    return 1;
 }
 
 /**
- * @brief Send repeated start condition
- * @retval 1 Successful
- * @retval 0 Timeout
+ * @brief Put transaction into queue
+ *
+ * The data buffer of the transaction is sent first (writelength bytes). If
+ * readlength is given, a (repeated) start follows and the received bytes
+ * are stored into the same buffer beginning at index 0.
+ *
+ * @param transaction Transaction to execute
+ * @retval 1 Transaction queued, status is I2C_STATUS_PENDING
+ * @retval 0 Queue full
+ */
+unsigned char i2c_enqueue(I2C_TRANSACTION * transaction) {
+
+    unsigned char nextpos = (i2c_queue_writepos + 1) % I2C_QUEUE_SIZE;
+    if (nextpos == i2c_queue_readpos) return 0;
+
+    transaction->status = I2C_STATUS_PENDING;
+    i2c_queue[i2c_queue_writepos] = transaction;
+    i2c_queue_writepos = nextpos;
+
+    // kick interrupt routine if bus is idle
+    if (i2c_state == I2C_STATE_IDLE) SSP1IF = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Get result of finished transaction and release it
+ * @param transaction Transaction
+ * @retval I2C_STATUS_PENDING Transaction still in progress
+ * @retval I2C_STATUS_DONE Transaction finished successfully
+ * @retval I2C_STATUS_ERROR Transaction failed
  */
-unsigned char i2c_repeatedStart() {
+unsigned char i2c_finish(I2C_TRANSACTION * transaction) {
 
-	// set start condition
-	SSPCON2bits.RSEN = 1;
+    unsigned char status = transaction->status;
+    if (status != I2C_STATUS_PENDING) transaction->status = I2C_STATUS_IDLE;
 
-	return waitForIF();
+    return status;
 }
 
 /**
- * @brief Send byte to i2c
+ * @brief Free a stuck bus
  *
- * @param b Byte to send out
- * @retval OK Sent byte successfully
- * @retval ERROR Error while sending byte
+ * A slave holding SDA low is clocked with up to 9 SCL pulses until it
+ * releases the line, followed by a stop condition.
  */
-unsigned char i2c_sendByte(unsigned char b) {
+void i2c_recoverBus() {
+
+    i2c_recoveries++;
 
-	// send byte
-	SSPBUF = b;
+    SSPCON1bits.SSPEN = 0;
 
-	if (!waitForIF()) return 0;
+    // emulate open drain outputs with tristate control
+    LATCbits.LATC0 = 0;
+    LATCbits.LATC1 = 0;
 
-	// Check if there was an ack
-	if (SSPCON2bits.ACKSTAT == 0)
-		return 1;
-	else
-		return 0;
+    unsigned char i;
+    for (i = 0; i < 9; i++) {
+        if (PORTCbits.RC1) break;
+        TRISCbits.TRISC0 = 0;
+        __delay_us(5);
+        TRISCbits.TRISC0 = 1;
+        __delay_us(5);
+    }
+
+    // stop condition
+    TRISCbits.TRISC0 = 0;
+    __delay_us(5);
+    TRISCbits.TRISC1 = 0;
+    __delay_us(5);
+    TRISCbits.TRISC0 = 1;
+    __delay_us(5);
+    TRISCbits.TRISC1 = 1;
+    __delay_us(5);
+
+    SSPCON1bits.SSPEN = 1;
 }
 
 /**
- * @brief Read byte from I2C
- *
- * @param b Pointer to byte read in from i2c
- * @param ack Acknowledge level which the master should set
- * @retval OK Received byte successfully
- * @retval ERROR Error while receiving byte
+ * @brief Check for timed out transactions and recover bus if necessary
  */
-unsigned char i2c_receiveByte(unsigned char * b, unsigned char ack) {
+void i2c_process() {
 
-	// switch to receiving mode
-	SSPCON2bits.RCEN = 1;
+    if (i2c_state == I2C_STATE_IDLE) return;
+    if ((i2c_state != I2C_STATE_RECOVER) && (clock_diff(i2c_laststamp) <= i2c_timeout)) return;
 
-	// wait for receive finish	
-	if (!waitForIF()) return 0;
+    // re-check with interrupts disabled, the interrupt routine may have
+    // finished the transaction and started the next one in the meantime
+    SSP1IE = 0;
+    BCL1IE = 0;
+    if ((i2c_state == I2C_STATE_IDLE) ||
+            ((i2c_state != I2C_STATE_RECOVER) && (clock_diff(i2c_laststamp) <= i2c_timeout))) {
+        BCL1IE = 1;
+        SSP1IE = 1;
+        return;
+    }
 
-	*b = SSPBUF;
+    // timeout, bus collision already failed the transaction
+    if (i2c_state != I2C_STATE_RECOVER) i2c_current->status = I2C_STATUS_ERROR;
 
+    i2c_recoverBus();
+    i2c_state = I2C_STATE_IDLE;
 
-    SSPCON2bits.ACKDT = ack;
-	SSPCON2bits.ACKEN = 1;
+    // continue with next queued transaction
+    SSP1IF = (i2c_queue_readpos != i2c_queue_writepos);
+    BCL1IE = 1;
+    SSP1IE = 1;
+}
 
-	if (!waitForIF()) return 0;
-	
-	return 1;
-/*
-	// Check if there was an ack
-	if (SSPCON2bits.ACKSTAT == 0)
-		return 1;
-	else
-		return 0;
-*/
+/**
+ * @brief Send stop condition and finish transaction with given status
+ * @param status Transaction status after stop condition
+ */
+void i2c_stop(unsigned char status) {
+    i2c_result = status;
+    SSPCON2bits.PEN = 1;
+    i2c_state = I2C_STATE_STOP;
 }
 
 /**
- * @brief Send stop condition
+ * @brief I2C interrupt routine, runs the transaction state machine
  */
-unsigned char i2c_stop(void) {
-	
-	// set stop condition
-	SSPCON2bits.PEN = 1;
+inline void i2c_isr() {
+
+    SSP1IF = 0;
+
+    if (BCL1IF) {
+        // bus collision, bus is recovered from i2c_process()
+        BCL1IF = 0;
+        if (i2c_state != I2C_STATE_IDLE) {
+            i2c_current->status = I2C_STATUS_ERROR;
+        }
+        i2c_state = I2C_STATE_RECOVER;
+    }
+
+    switch (i2c_state) {
+
+        case I2C_STATE_IDLE:
+            if (i2c_queue_readpos == i2c_queue_writepos) break;
+
+            i2c_current = i2c_queue[i2c_queue_readpos];
+            i2c_queue_readpos = (i2c_queue_readpos + 1) % I2C_QUEUE_SIZE;
+            i2c_pos = 0;
+            i2c_laststamp = clock_tickerSlow;
+
+            SSPCON2bits.SEN = 1;
+            i2c_state = I2C_STATE_START;
+            break;
+
+        case I2C_STATE_START:
+            if (i2c_current->writelength) {
+                SSPBUF = i2c_current->address;
+                i2c_state = I2C_STATE_WRITE;
+            } else {
+                SSPBUF = i2c_current->address | 1;
+                i2c_state = I2C_STATE_READADDRESS;
+            }
+            break;
+
+        case I2C_STATE_WRITE:
+            if (SSPCON2bits.ACKSTAT) {
+                i2c_stop(I2C_STATUS_ERROR);
+            } else if (i2c_pos < i2c_current->writelength) {
+                SSPBUF = i2c_current->data[i2c_pos];
+                i2c_pos++;
+            } else if (i2c_current->readlength) {
+                i2c_pos = 0;
+                SSPCON2bits.RSEN = 1;
+                i2c_state = I2C_STATE_RESTART;
+            } else {
+                i2c_stop(I2C_STATUS_DONE);
+            }
+            break;
+
+        case I2C_STATE_RESTART:
+            SSPBUF = i2c_current->address | 1;
+            i2c_state = I2C_STATE_READADDRESS;
+            break;
+
+        case I2C_STATE_READADDRESS:
+            if (SSPCON2bits.ACKSTAT) {
+                i2c_stop(I2C_STATUS_ERROR);
+            } else {
+                SSPCON2bits.RCEN = 1;
+                i2c_state = I2C_STATE_READ;
+            }
+            break;
+
+        case I2C_STATE_READ:
+            i2c_current->data[i2c_pos] = SSPBUF;
+            i2c_pos++;
+
+            // nack last byte
+            SSPCON2bits.ACKDT = (i2c_pos == i2c_current->readlength);
+            SSPCON2bits.ACKEN = 1;
+            i2c_state = I2C_STATE_ACK;
+            break;
+
+        case I2C_STATE_ACK:
+            if (i2c_pos < i2c_current->readlength) {
+                SSPCON2bits.RCEN = 1;
+                i2c_state = I2C_STATE_READ;
+            } else {
+                i2c_stop(I2C_STATUS_DONE);
+            }
+            break;
+
+        case I2C_STATE_STOP:
+            i2c_current->status = i2c_result;
+            i2c_state = I2C_STATE_IDLE;
 
-	return	waitForIF();
+            // continue with next queued transaction
+            if (i2c_queue_readpos != i2c_queue_writepos) SSP1IF = 1;
+            break;
+    }
 }
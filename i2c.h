@@ -25,14 +25,48 @@
 #define	I2C_H
 
 #define _XTAL_FREQ 48000000
-#define I2C_SCL 50000
+#define I2C_QUEUE_SIZE 4
+
+/* Bus clock presets */
+#define I2C_SPEED_50KHZ 0
+#define I2C_SPEED_100KHZ 1
+#define I2C_SPEED_400KHZ 2
+#define I2C_SPEED_NROF 3
+
+/* Transaction status */
+#define I2C_STATUS_IDLE 0
+#define I2C_STATUS_PENDING 1
+#define I2C_STATUS_DONE 2
+#define I2C_STATUS_ERROR 3
+
+/* Bus states */
+#define I2C_STATE_IDLE 0
+#define I2C_STATE_START 1
+#define I2C_STATE_WRITE 2
+#define I2C_STATE_RESTART 3
+#define I2C_STATE_READADDRESS 4
+#define I2C_STATE_READ 5
+#define I2C_STATE_ACK 6
+#define I2C_STATE_STOP 7
+#define I2C_STATE_RECOVER 8
+
+typedef struct
+{
+    unsigned char address;
+    unsigned char * data;
+    unsigned char writelength;
+    unsigned char readlength;
+    volatile unsigned char status;
+} I2C_TRANSACTION;
 
 void i2c_init();
-unsigned char i2c_start();
-unsigned char i2c_repeatedStart();
-unsigned char i2c_sendByte(unsigned char b);
-unsigned char i2c_receiveByte(unsigned char * b, unsigned char ack);
-unsigned char i2c_stop(void);
+unsigned char i2c_setSpeed(unsigned char speed);
+unsigned char i2c_enqueue(I2C_TRANSACTION * transaction);
+unsigned char i2c_finish(I2C_TRANSACTION * transaction);
+void i2c_process();
+inline void i2c_isr();
+
+extern unsigned short i2c_recoveries;
 
 
 #endif	/* I2D_H */
@@ -0,0 +1,275 @@
+/**
+ * @file logger.c
+ *
+ * @brief This file contains the flash data logger of the THERMOsera firmware
+ *        project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "clock.h"
+#include "usb_cdc.h"
+#include "settings.h"
+#include "history.h"
+#include "logger.h"
+
+// reserve flash rows, so the linker doesn't place code there
+const unsigned char logger_flash[LOGGER_ROWS * FLASH_ROWSIZE] HAL_AT(LOGGER_FLASH_ADDRESS) = {0xff};
+const unsigned char logger_hef[LOGGER_HEF_ROWS * FLASH_ROWSIZE] HAL_AT(LOGGER_HEF_ADDRESS) = {0xff};
+
+// first row and count of rows of LOGGER_AREA_xxx
+const unsigned short logger_areaaddress[LOGGER_AREA_NROF] = {LOGGER_FLASH_ADDRESS, LOGGER_HEF_ADDRESS};
+const unsigned char logger_arearows[LOGGER_AREA_NROF] = {LOGGER_ROWS, LOGGER_HEF_ROWS};
+
+// interval in seconds of LOGGER_INTERVAL_xxx
+const unsigned short logger_intervals[LOGGER_INTERVAL_NROF] = {0, 1, 10, 30, 60, 300, 600, 3600};
+
+unsigned char logger_block[HISTORY_BLOCKSIZE]; // block not written to flash yet
+signed short logger_last[CHANNELS_NROF + 1];
+unsigned char logger_row[LOGGER_AREA_NROF]; // next row to write
+unsigned char logger_sequence[LOGGER_AREA_NROF];
+
+unsigned char logger_laststamp;
+unsigned char logger_ticks = 0;
+unsigned short logger_seconds = 0;
+unsigned char logger_due = 0; // intervals elapsed since last record
+
+unsigned short logger_dumpleft = 0;
+unsigned char logger_dumpindex; // row index from oldest row, regular rows first, LOGGER_ROWS + LOGGER_HEF_ROWS for RAM block
+unsigned char logger_dumppos;
+
+/**
+ * @brief Get area of the records with given log interval
+ * @param interval Log interval (LOGGER_INTERVAL_xxx)
+ * @return Flash area (LOGGER_AREA_xxx)
+ */
+unsigned char logger_area(unsigned char interval) {
+    if (interval < LOGGER_INTERVAL_FLASH_MIN) return LOGGER_AREA_HEF;
+    return LOGGER_AREA_FLASH;
+}
+
+/**
+ * @brief Get program memory address of given row
+ * @param area Flash area (LOGGER_AREA_xxx)
+ * @param row Row index in area
+ * @return Start address of row
+ */
+unsigned short logger_rowAddress(unsigned char area, unsigned char row) {
+    return logger_areaaddress[area] + (unsigned short) row * FLASH_ROWSIZE;
+}
+
+/**
+ * @brief Determine if given row holds a log block
+ * @param area Flash area (LOGGER_AREA_xxx)
+ * @param row Row index in area
+ * @return 0 if row is erased or invalid
+ */
+unsigned char logger_rowValid(unsigned char area, unsigned char row) {
+    unsigned char length = flash_read(logger_rowAddress(area, row) + HISTORY_HEADER_LENGTH);
+    return (length > HISTORY_HEADER_SIZE) && (length <= HISTORY_BLOCKSIZE);
+}
+
+/**
+ * @brief Find newest row of each area to continue log after it
+ *
+ * The newest row is the only valid one which isn't followed by a row with
+ * the next sequence counter.
+ */
+void logger_init() {
+
+    logger_laststamp = clock_tickerSlow;
+
+    unsigned char area;
+    for (area = 0; area < LOGGER_AREA_NROF; area++) {
+
+        unsigned char rows = logger_arearows[area];
+        logger_row[area] = 0;
+        logger_sequence[area] = 0;
+
+        unsigned char row;
+        for (row = 0; row < rows; row++) {
+
+            if (!logger_rowValid(area, row)) continue;
+
+            unsigned char sequence = flash_read(logger_rowAddress(area, row) + HISTORY_HEADER_SEQUENCE);
+            unsigned char next = row + 1;
+            if (next == rows) next = 0;
+
+            if (logger_rowValid(area, next) &&
+                    (flash_read(logger_rowAddress(area, next) + HISTORY_HEADER_SEQUENCE) == (unsigned char) (sequence + 1))) continue;
+
+            logger_row[area] = next;
+            logger_sequence[area] = sequence + 1;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Write pending block to the next row of the area of its interval
+ */
+void logger_flush() {
+
+    if (logger_block[HISTORY_HEADER_LENGTH] == 0) return;
+
+    unsigned char area = logger_area(logger_block[HISTORY_HEADER_MASK] >> HISTORY_MASK_TIMEUNIT_SHIFT);
+    flash_writeRow(logger_rowAddress(area, logger_row[area]), logger_block, logger_block[HISTORY_HEADER_LENGTH]);
+    logger_block[HISTORY_HEADER_LENGTH] = 0;
+
+    logger_row[area]++;
+    if (logger_row[area] == logger_arearows[area]) logger_row[area] = 0;
+}
+
+/**
+ * @brief Set log interval
+ *
+ * The pending block is written to flash, so logging can be stopped without
+ * losing records. Intervals shorter than LOGGER_INTERVAL_MIN would wear
+ * out the flash and are refused.
+ *
+ * @param interval Log interval (LOGGER_INTERVAL_xxx)
+ * @retval 1 Successful
+ * @retval 0 Invalid interval
+ */
+unsigned char logger_setInterval(unsigned char interval) {
+
+    if (interval >= LOGGER_INTERVAL_NROF) return 0;
+    if ((interval != LOGGER_INTERVAL_OFF) && (interval < LOGGER_INTERVAL_MIN)) return 0;
+
+    logger_flush();
+    settings.loginterval = interval;
+    logger_seconds = 0;
+    logger_due = 0;
+    return 1;
+}
+
+/**
+ * @brief Count log interval and handle pending dump
+ */
+void logger_process() {
+
+    unsigned char ticks = clock_diff(logger_laststamp);
+    logger_laststamp += ticks;
+    logger_ticks += ticks;
+    while (logger_ticks >= 100) {
+        logger_ticks -= 100;
+        logger_seconds++;
+    }
+
+    if (settings.loginterval && (logger_seconds >= logger_intervals[settings.loginterval])) {
+        logger_seconds -= logger_intervals[settings.loginterval];
+        if (logger_due < 0xff) logger_due++;
+    }
+
+    if (!logger_dumpleft) return;
+
+    if (!usb_isOpen()) {
+        logger_dumpleft = 0;
+        return;
+    }
+
+    // oldest row of each area first, followed by the pending block
+    unsigned char free = usb_txFree();
+    while (free && logger_dumpleft) {
+
+        unsigned char ch;
+        if (logger_dumpindex < LOGGER_ROWS + LOGGER_HEF_ROWS) {
+            unsigned char area = LOGGER_AREA_FLASH;
+            unsigned char index = logger_dumpindex;
+            if (index >= LOGGER_ROWS) {
+                area = LOGGER_AREA_HEF;
+                index -= LOGGER_ROWS;
+            }
+            unsigned char row = (logger_row[area] + index) % logger_arearows[area];
+            if (!logger_rowValid(area, row)) {
+                logger_dumpindex++;
+                continue;
+            }
+            ch = flash_read(logger_rowAddress(area, row) + logger_dumppos);
+        } else {
+            ch = logger_block[logger_dumppos];
+        }
+
+        usb_putch(ch);
+        free--;
+        logger_dumpleft--;
+
+        logger_dumppos++;
+        if (logger_dumppos == HISTORY_BLOCKSIZE) {
+            logger_dumppos = 0;
+            logger_dumpindex++;
+        }
+    }
+
+    usb_txCommit();
+}
+
+/**
+ * @brief Log record if the log interval has elapsed
+ *
+ * Full blocks are written to the flash area of the log interval. The time of
+ * the records is given in log intervals. While the log is dumped, the record
+ * is postponed.
+ *
+ * @param mask Values to log (FRAME_MASK_xxx)
+ * @param values Channel values and ambient value (0.1 degree or
+ *        VALUE_INVALID_BINARY)
+ */
+void logger_add(unsigned char mask, int24_t * values) {
+
+    if (!logger_due || logger_dumpleft) return;
+
+    signed short current[CHANNELS_NROF + 1];
+    history_convert(current, values);
+
+    mask |= settings.loginterval << HISTORY_MASK_TIMEUNIT_SHIFT;
+
+    if (!history_append(logger_block, mask, logger_due, current, logger_last)) {
+        logger_flush();
+        unsigned char area = logger_area(settings.loginterval);
+        history_startBlock(logger_block, logger_sequence[area]++, mask, logger_due, current, logger_last);
+    }
+
+    logger_due = 0;
+}
+
+/**
+ * @brief Start dump of all log rows and the pending block
+ *
+ * The regular rows are dumped before the high-endurance ones, each area
+ * oldest first.
+ *
+ * @return Count of bytes to dump
+ */
+unsigned short logger_dumpStart() {
+
+    unsigned char blocks = 0;
+    unsigned char area;
+    for (area = 0; area < LOGGER_AREA_NROF; area++) {
+        unsigned char row;
+        for (row = 0; row < logger_arearows[area]; row++) {
+            if (logger_rowValid(area, row)) blocks++;
+        }
+    }
+    if (logger_block[HISTORY_HEADER_LENGTH]) blocks++;
+
+    logger_dumpindex = 0;
+    logger_dumppos = 0;
+    logger_dumpleft = blocks * HISTORY_BLOCKSIZE;
+    return logger_dumpleft;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file logger.h
+ *
+ * @brief This file contains the definitions for the flash data logger of the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef LOGGER_H
+#define	LOGGER_H
+
+#include "flash.h"
+
+/*
+ * The log is a ring of history blocks (see history.h) in flash rows: the
+ * regular program flash rows below the settings row for the long intervals
+ * and the high-endurance rows behind the settings row for the short ones.
+ * The rows of an area are written in turn, the newest one is found by the
+ * sequence counters after reset.
+ */
+#define LOGGER_FLASH_ADDRESS 0x1C00
+#define LOGGER_ROWS ((FLASH_HEF_ADDRESS - LOGGER_FLASH_ADDRESS) / FLASH_ROWSIZE)
+#define LOGGER_HEF_ADDRESS (FLASH_HEF_ADDRESS + FLASH_ROWSIZE)
+#define LOGGER_HEF_ROWS ((FLASH_END_ADDRESS - LOGGER_HEF_ADDRESS) / FLASH_ROWSIZE)
+
+#define LOGGER_AREA_FLASH 0
+#define LOGGER_AREA_HEF 1
+#define LOGGER_AREA_NROF 2
+
+/*
+ * Log interval (also time unit of the log records)
+ *
+ * A row holds 2..4 records with all values enabled.
+ * - From LOGGER_INTERVAL_FLASH_MIN on, the 28 regular rows are used. They
+ *   endure about 10k erase cycles, so they wear out after 560k..1.1M
+ *   records, after at least 5 years at 5 min. They keep the last 56..112
+ *   records, e.g. 4.6..9.3 h at 5 min.
+ * - The shorter intervals use the 3 high-endurance rows (100k cycles),
+ *   which wear out after 600k..1.2M records, e.g. after 2..4 months at 10 s
+ *   or 1..2 years at 1 min. They keep only the last 6..12 records.
+ * - Intervals below LOGGER_INTERVAL_MIN are refused: 1 s would wear out the
+ *   high-endurance rows within 1..2 weeks, the RAM history covers that time
+ *   span instead. They are kept for the time unit of logs already written.
+ *
+ * The records of the block not written yet (up to one row) are held in RAM.
+ * The block is written to flash when the interval is changed (e.g. with
+ * 'L0' before unplugging) and when the host suspends the USB bus. A power
+ * loss without either loses these records.
+ */
+#define LOGGER_INTERVAL_OFF 0
+#define LOGGER_INTERVAL_1S 1
+#define LOGGER_INTERVAL_10S 2
+#define LOGGER_INTERVAL_30S 3
+#define LOGGER_INTERVAL_1MIN 4
+#define LOGGER_INTERVAL_5MIN 5
+#define LOGGER_INTERVAL_10MIN 6
+#define LOGGER_INTERVAL_1H 7
+#define LOGGER_INTERVAL_NROF 8
+#define LOGGER_INTERVAL_MIN LOGGER_INTERVAL_10S
+#define LOGGER_INTERVAL_FLASH_MIN LOGGER_INTERVAL_5MIN // shorter ones use LOGGER_AREA_HEF
+
+void logger_init();
+unsigned char logger_setInterval(unsigned char interval);
+void logger_process();
+void logger_add(unsigned char mask, int24_t * values);
+void logger_flush();
+unsigned short logger_dumpStart();
+
+extern unsigned short logger_dumpleft;
+
+#endif
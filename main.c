@@ -22,34 +22,126 @@
  * 
  */
 
-#include <xc.h>
+#include "hal.h"
 #include "usb_cdc.h"
 #include "i2c.h"
 #include "clock.h"
 #include "uart.h"
 #include "mcp3424.h"
 #include "mcp9800.h"
+#include "settings.h"
 #include "thermosera.h"
+#include "thermocouple.h"
+#include "history.h"
+#include "logger.h"
+#include "filter.h"
+#include "bench/bench.h"
 
 #define STATE_TRIGGER 0
 #define STATE_WAIT 1
 #define STATE_READ 2
+#define STATE_CONTINUOUS 3
+#define STATE_AMBIENT 4
+#define STATE_AMBIENT_TRIGGER 5
+#define STATE_IDLE 6
 
-#define CHANNELS_NROF 4
+// ambient refresh during continuous conversion
+#define AMBIENT_PHASE_READ 0
+#define AMBIENT_PHASE_TRIGGER 1
+#define AMBIENT_PHASE_WAIT 2
+#define AMBIENT_REFRESH_TICKS 100 // slow ticks between ambient readings
 
-unsigned char channel_mapping[] = {2, 3, 0, 1};
+#define REPLY_LENGTH_MAX 26 // longest command reply ('H'): letter, six hex words, CR
+
+const unsigned char channel_mapping[] = {2, 3, 0, 1};
 
 unsigned char state = STATE_TRIGGER;
 unsigned char state_laststamp;
-unsigned char channel = 0;
-signed short long temperature[CHANNELS_NROF];
+unsigned char channel = 0; // channel in scan (index in channel_mapping)
+int24_t emf[CHANNELS_NROF]; // uV
+signed short temperature[CHANNELS_NROF]; // compensated, 0.1 degree (range of the tables)
+unsigned long stamp[CHANNELS_NROF + 1]; // ms of conversion completion (incl. ambient)
+signed short ambient = 0;
+unsigned char valid = 0; // valid values (FRAME_MASK_xxx)
+unsigned char continuous = 0;
+unsigned char ambient_phase = AMBIENT_PHASE_READ;
+unsigned char ambient_laststamp;
+unsigned char frame_sequence = 0;
+unsigned char frame_crc;
+unsigned char frame_omitted = 0; // channels printed as empty ASCII column (FRAME_MASK_xxx)
+unsigned long scan_deadline = 0; // ms to start next scan
+unsigned short scan_overruns = 0;
+
+// deadband reporting, last reported value and time of each channel
+int24_t report_value[CHANNELS_NROF + 1];
+unsigned long report_time[CHANNELS_NROF + 1];
+unsigned char report_force = 0xff; // channels to report regardless of deadband
+
+// heartbeat interval in ms of REPORT_HEARTBEAT_xxx
+const unsigned long report_heartbeats[REPORT_HEARTBEAT_NROF] = {0, 1000, 10000, 60000, 600000, 3600000};
+
+// scan interval in ms of SCAN_INTERVAL_xxx
+const unsigned short scan_intervals[SCAN_INTERVAL_NROF] = {0, 100, 250, 500, 1000, 2000, 5000, 10000, 30000, 60000};
+unsigned char print_usb = 1; // USB output enabled for current print
+
+/**
+ * @brief Advance scan to next enabled channel (or CHANNELS_NROF if none left)
+ */
+void scan_skipDisabledChannels() {
+    while ((channel < CHANNELS_NROF) && !(settings.channelmask & (1 << channel))) {
+        channel++;
+    }
+}
+
+/**
+ * @brief Restart scan with first enabled channel
+ *
+ * With a scan interval set, the scan waits for the next deadline.
+ */
+void scan_restart() {
+    // a conversion of the previous scan must not be taken for this one
+    mcp3424_discard();
+
+    channel = 0;
+    scan_skipDisabledChannels();
+    if (settings.scaninterval) state = STATE_IDLE;
+    else state = STATE_TRIGGER;
+}
+
+/**
+ * @brief Check deadline of next scan after a finished scan
+ *
+ * If the deadline has already passed, the scan took longer than the
+ * interval. This is counted as overrun and the missed deadlines are
+ * skipped, so the scans stay on the interval grid.
+ */
+void scan_checkOverrun() {
+
+    if (!settings.scaninterval) return;
+
+    unsigned long now = clock_getMillis();
+    if ((signed long) (now - scan_deadline) < 0) return;
+
+    scan_overruns++;
+    do {
+        scan_deadline += scan_intervals[settings.scaninterval];
+    } while ((signed long) (now - scan_deadline) >= 0);
+}
+
+/**
+ * @brief Determine if a dump is sent on USB
+ * @return 0 if no dump in progress
+ */
+unsigned char dump_active() {
+    return history_dumpleft || logger_dumpleft;
+}
 
 /**
  * @brief Print out character
  * @param ch Character to print out
  */
 void print_ch(char ch) {
-    usb_putch(ch);
+    if (print_usb) usb_putch(ch);
     uart_putch(ch);
 }
 
@@ -64,12 +156,21 @@ void print_str(char * s) {
     }
 }
 
+// decades for digit extraction by subtraction
+const unsigned short print_decades[] = {10000, 1000, 100, 10};
+
 /**
  * @brief Print out given value as degree
- * @param val Temperature value to print out
+ *
+ * The digits are extracted by repeated subtraction of decades. The value
+ * is right aligned in a field of VALUE_WIDTH_ASCII characters and rounded
+ * to the given decimal places.
+ *
+ * @param val Temperature value to print out (0.1 degree, |val| <= 65530)
+ * @param decimals Decimal places to print out (0..VALUE_DECIMALS)
  */
-void print_degree(signed short long val) {
-    char s[10];
+void print_degree(int24_t val, unsigned char decimals) {
+    char digits[5];
     unsigned char neg = 0;
 
     if (val < 0) {
@@ -77,26 +178,296 @@ void print_degree(signed short long val) {
         val = -val;
     }
 
-    char pos = 7;
-    while (pos > 0) {
+    // round away decimal places which aren't printed out
+    if (decimals == 0) val += 5;
 
-        pos--;
+    unsigned short v = val;
+    unsigned char i;
+    for (i = 0; i < 4; i++) {
+        char d = '0';
+        while (v >= print_decades[i]) {
+            v -= print_decades[i];
+            d++;
+        }
+        digits[i] = d;
+    }
+    digits[4] = '0' + v;
+
+    // skip leading zeros, keep at least one integer digit
+    unsigned char first = 0;
+    while ((first < 4 - VALUE_DECIMALS) && (digits[first] == '0')) first++;
+
+    unsigned char last = 4 - VALUE_DECIMALS + decimals;
+    if ((first == last) && (digits[first] == '0')) neg = 0;
+
+    unsigned char width = last - first + 1 + neg;
+    if (decimals) width++;
+    while (width < VALUE_WIDTH_ASCII) {
+        print_ch(' ');
+        width++;
+    }
 
-        if (pos == 5) {
-            s[pos] = '.';
-        } else if ((pos > 3) || (val != 0)) {
-            s[pos] = '0' + (val % 10);
-            val = val / 10;
-        } else if (neg) {
-            s[pos] = '-';
-            neg = 0;
+    if (neg) print_ch('-');
+    for (i = first; i <= last; i++) {
+        if (i == 5 - VALUE_DECIMALS) print_ch('.');
+        print_ch(digits[i]);
+    }
+}
+
+// decades for digit extraction of timestamps
+const unsigned long print_decadesLong[] = {1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10};
+
+/**
+ * @brief Print out given timestamp as decimal number without leading zeros
+ * @param val Timestamp to print out (ms)
+ */
+void print_stamp(unsigned long val) {
+    unsigned char leading = 1;
+    unsigned char i;
+    for (i = 0; i < sizeof (print_decadesLong) / sizeof (unsigned long); i++) {
+        char d = '0';
+        while (val >= print_decadesLong[i]) {
+            val -= print_decadesLong[i];
+            d++;
+        }
+        if ((d == '0') && leading) continue;
+        leading = 0;
+        print_ch(d);
+    }
+    print_ch('0' + (unsigned char) val);
+}
+
+/**
+ * @brief Print out byte of binary frame and update frame checksum
+ * @param b Byte to print out
+ */
+void print_frameByte(unsigned char b) {
+
+    print_ch(b);
+
+    frame_crc ^= b;
+    unsigned char i;
+    for (i = 0; i < 8; i++) {
+        if (frame_crc & 0x80) frame_crc = (frame_crc << 1) ^ FRAME_CRC_POLYNOM;
+        else frame_crc = frame_crc << 1;
+    }
+}
+
+/**
+ * @brief Print out given 16 bit value as hex number
+ * @param val Value to print out
+ */
+void print_hex(unsigned short val) {
+    signed char shift;
+    for (shift = 12; shift >= 0; shift -= 4) {
+        unsigned char nibble = (val >> shift) & 0x0f;
+        if (nibble > 9) print_ch('A' + nibble - 10);
+        else print_ch('0' + nibble);
+    }
+}
+
+/**
+ * @brief Determine if value of given channel is valid
+ * @param i Channel index (CHANNELS_NROF for ambient)
+ * @return 0 if value is invalid
+ */
+unsigned char value_valid(unsigned char i) {
+    // channel values are compensated with ambient temperature
+    if (!(valid & FRAME_MASK_AMBIENT)) return 0;
+    return valid & (1 << i);
+}
+
+/**
+ * @brief Get value of given channel
+ * @param i Channel index (CHANNELS_NROF for ambient)
+ * @return Temperature in 0.1 degree or VALUE_INVALID_BINARY
+ */
+int24_t value_get(unsigned char i) {
+    if (!value_valid(i)) return VALUE_INVALID_BINARY;
+    if (i == CHANNELS_NROF) return ambient;
+    return temperature[i];
+}
+
+/**
+ * @brief Calculate compensated temperature of given channel
+ *
+ * The ambient (cold junction) temperature is converted to its equivalent
+ * thermoelectric voltage, added to the measured voltage and the sum is
+ * converted back to the temperature.
+ *
+ * @param i Channel index
+ */
+void compensate(unsigned char i) {
+    unsigned char type = settings.tctype[i];
+    int24_t e = emf[i] + thermocouple_getEmf(type, ambient);
+    temperature[i] = (signed short) thermocouple_getTemperature(type, e);
+}
+
+/**
+ * @brief Print out 24 bit value in binary frame
+ * @param val Value to print out
+ */
+void print_frameValue(int24_t val) {
+    print_frameByte((unsigned char) (val >> 16));
+    print_frameByte((unsigned char) (val >> 8));
+    print_frameByte((unsigned char) val);
+}
+
+/**
+ * @brief Print out measured temperatures as ASCII line
+ *
+ * Channels in frame_omitted are printed as empty column, so the columns
+ * keep their position.
+ *
+ * @param mask Channels to print out (FRAME_MASK_xxx)
+ */
+void print_asciiFrame(unsigned char mask) {
+
+    unsigned char first = 1;
+
+    print_ch(' ');
+
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+
+        if (!((mask | frame_omitted) & (1 << i))) continue;
+
+        if (!first) print_str((char*) ", ");
+        first = 0;
+
+        if (frame_omitted & (1 << i)) {
+            print_str((char*) VALUE_OMITTED_ASCII);
+            continue;
+        }
+
+        if (!value_valid(i)) print_str((char*) VALUE_INVALID_ASCII);
+        else if (i == CHANNELS_NROF) print_degree(ambient, settings.decimals);
+        else print_degree(temperature[i], settings.decimals);
+
+        if (mask & FRAME_MASK_TIMESTAMPS) {
+            print_ch('@');
+            print_stamp(stamp[i]);
+        }
+    }
+
+    print_ch(CR);
+}
+
+/**
+ * @brief Print out measured temperatures as binary frame
+ * @param mask Channels to print out (FRAME_MASK_xxx)
+ */
+void print_binaryFrame(unsigned char mask) {
+
+    print_ch(FRAME_SYNC);
+
+    frame_crc = 0;
+    print_frameByte(frame_sequence);
+    print_frameByte(mask);
+
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+
+        if (!(mask & (1 << i))) continue;
+
+        print_frameValue(value_get(i));
+
+        if (mask & FRAME_MASK_TIMESTAMPS) {
+            print_frameByte((unsigned char) (stamp[i] >> 24));
+            print_frameByte((unsigned char) (stamp[i] >> 16));
+            print_frameByte((unsigned char) (stamp[i] >> 8));
+            print_frameByte((unsigned char) stamp[i]);
+        }
+    }
+
+    print_ch(frame_crc);
+
+    frame_sequence++;
+}
+
+/**
+ * @brief Print out measured temperatures in selected output format
+ *
+ * The frame goes to USB only if the port is opened and the whole frame
+ * fits into the send buffer, so the host never sees a torn frame. A skipped
+ * frame still advances the sequence counter. While the history or the log
+ * is dumped, frames go to UART only.
+ *
+ * @param mask Channels to print out (FRAME_MASK_xxx)
+ */
+void print_frame(unsigned char mask) {
+
+    unsigned char count = 0;
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+        if (mask & (1 << i)) count++;
+        else if ((frame_omitted & (1 << i)) && (settings.outputformat == OUTPUT_FORMAT_ASCII)) count++;
+    }
+
+    if (settings.timestamps) mask |= FRAME_MASK_TIMESTAMPS;
+
+    if (settings.outputformat == OUTPUT_FORMAT_BINARY) {
+        // sync, sequence, mask, values (with timestamps), crc
+        unsigned char width = 3;
+        if (settings.timestamps) width += 4;
+        print_usb = !dump_active() && usb_txReserve(4 + width * count);
+        print_binaryFrame(mask);
+    } else {
+        // leading space, values (with timestamps) separated by ", ", CR
+        unsigned char width = VALUE_WIDTH_ASCII + 2;
+        if (settings.timestamps) width += STAMP_WIDTH_ASCII;
+        print_usb = !dump_active() && usb_txReserve(width * count);
+        print_asciiFrame(mask);
+    }
+
+    usb_txCommit();
+}
+
+/**
+ * @brief Select channels to report in deadband mode
+ *
+ * A channel is reported if it has no deadband, if it has moved by at least
+ * its deadband since its last report or if its validity has changed. The
+ * heartbeat reports every channel which was silent for the heartbeat
+ * interval.
+ *
+ * @param mask Channels of finished scan (FRAME_MASK_xxx)
+ * @return Channels to report (FRAME_MASK_xxx)
+ */
+unsigned char report_select(unsigned char mask) {
+
+    unsigned long now = clock_getMillis();
+    unsigned long heartbeat = report_heartbeats[settings.heartbeat];
+
+    unsigned char i;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+
+        unsigned char bit = 1 << i;
+        if (!(mask & bit)) continue;
+
+        int24_t value = value_get(i);
+        unsigned char report = (report_force & bit) || !settings.deadband[i];
+
+        if ((value == VALUE_INVALID_BINARY) || (report_value[i] == VALUE_INVALID_BINARY)) {
+            if (value != report_value[i]) report = 1;
         } else {
-            s[pos] = ' ';
+            int24_t delta = value - report_value[i];
+            if (delta < 0) delta = -delta;
+            if (delta >= settings.deadband[i]) report = 1;
         }
 
+        if (heartbeat && (now - report_time[i] >= heartbeat)) report = 1;
+
+        if (report) {
+            report_value[i] = value;
+            report_time[i] = now;
+        } else {
+            mask &= ~bit;
+        }
     }
-    s[7] = 0;
-    print_str(s);
+
+    report_force &= ~mask;
+    return mask;
 }
 
 /**
@@ -107,6 +478,9 @@ void parseLine(char * line) {
 
     unsigned char result = BELL;
 
+    // the whole reply or nothing, a reply which doesn't fit counts as dropped
+    print_usb = !dump_active() && usb_txReserve(REPLY_LENGTH_MAX);
+
     switch (line[0]) {
         case 'v': // Get firmware version
         {
@@ -115,9 +489,285 @@ void parseLine(char * line) {
             result = CR;
         }
             break;
+        case 'B': // Set UART baudrate
+        {
+            unsigned char baudrate = line[1] - '0';
+            if (uart_setBaudrate(baudrate)) {
+                settings.baudrate = baudrate;
+                result = CR;
+            }
+        }
+            break;
+        case 'F': // Set output format
+        {
+            unsigned char outputformat = line[1] - '0';
+            if (outputformat <= OUTPUT_FORMAT_BINARY) {
+                settings.outputformat = outputformat;
+                result = CR;
+            }
+        }
+            break;
+        case 'D': // Set decimal places of ASCII output
+        {
+            unsigned char decimals = line[1] - '0';
+            if (decimals <= VALUE_DECIMALS) {
+                settings.decimals = decimals;
+                result = CR;
+            }
+        }
+            break;
+        case 'S': // Set timestamps in frames (0 = off, 1 = on)
+        {
+            unsigned char timestamps = line[1] - '0';
+            if (timestamps <= 1) {
+                settings.timestamps = timestamps;
+                result = CR;
+            }
+        }
+            break;
+        case 'R': // Set ADC resolution of channel
+        case 'G': // Set ADC gain of channel
+        {
+            unsigned char ch = line[1] - '1';
+            unsigned char value = line[2] - '0';
+            if ((ch < CHANNELS_NROF) && (value <= 3)) {
+                unsigned char * config = &settings.adcconfig[ch];
+                if (line[0] == 'R') {
+                    *config = (*config & ~MCP3424_CONFIG_RESOLUTION_MASK) | (value << MCP3424_CONFIG_RESOLUTION_SHIFT);
+                } else {
+                    *config = (*config & ~MCP3424_CONFIG_GAIN_MASK) | value;
+                }
+
+                // discard conversion and filter history of the old config
+                filter_reset(ch);
+                scan_deadline = clock_getMillis();
+                scan_restart();
+                result = CR;
+            }
+        }
+            break;
+        case 'P': // Set ADC ready polling
+        {
+            unsigned char adcpolling = line[1] - '0';
+            if (adcpolling <= 1) {
+                settings.adcpolling = adcpolling;
+                result = CR;
+            }
+        }
+            break;
+        case 'C': // Continuous conversion on single channel (0 = off)
+        {
+            unsigned char ch = line[1] - '0';
+            if (ch <= CHANNELS_NROF) {
+                continuous = ch;
+                scan_deadline = clock_getMillis();
+                scan_restart();
+                result = CR;
+            }
+        }
+            break;
+        case 'A': // Set scan interval (SCAN_INTERVAL_xxx, 0 = free running)
+        {
+            unsigned char interval = line[1] - '0';
+            if (interval < SCAN_INTERVAL_NROF) {
+                settings.scaninterval = interval;
+                scan_deadline = clock_getMillis();
+                scan_restart();
+                result = CR;
+            }
+        }
+            break;
+        case 'O': // Get count of scan overruns
+        {
+            print_ch('O');
+            print_hex(scan_overruns);
+            result = CR;
+        }
+            break;
+        case 'M': // Set channel enable mask (hex digit)
+        {
+            char digit = line[1];
+            unsigned char mask = 0;
+            if ((digit >= '0') && (digit <= '9')) mask = digit - '0';
+            else if ((digit >= 'A') && (digit <= 'F')) mask = digit - 'A' + 10;
+            else if ((digit >= 'a') && (digit <= 'f')) mask = digit - 'a' + 10;
+            if ((mask > 0) && (mask <= FRAME_MASK_CHANNELS)) {
+                settings.channelmask = mask;
+                report_force = 0xff;
+                scan_deadline = clock_getMillis();
+                scan_restart();
+                result = CR;
+            }
+        }
+            break;
+        case 'T': // Set thermocouple type of channel
+        {
+            unsigned char ch = line[1] - '1';
+            const char * letters = THERMOCOUPLE_TYPE_LETTERS;
+            unsigned char type = 0;
+            while ((type < THERMOCOUPLE_TYPE_NROF) && (letters[type] != line[2])) type++;
+            if ((ch < CHANNELS_NROF) && (type < THERMOCOUPLE_TYPE_NROF)) {
+                settings.tctype[ch] = type;
+                result = CR;
+            }
+        }
+            break;
+        case 'N': // Set filter of channel (type letter, parameter digit)
+        {
+            unsigned char ch = line[1] - '1';
+            const char * letters = FILTER_TYPE_LETTERS;
+            unsigned char type = 0;
+            while ((type < FILTER_TYPE_NROF) && (letters[type] != line[2])) type++;
+            if ((ch < CHANNELS_NROF) && (type < FILTER_TYPE_NROF) &&
+                    filter_set(ch, type, line[3] - '0')) result = CR;
+        }
+            break;
+        case 'Z': // Set deadband of channel (5 = ambient) in 0.1 degree, 0 = report every scan
+        {
+            unsigned char ch = line[1] - '1';
+            unsigned short deadband = 0;
+            unsigned char pos = 2;
+            while ((line[pos] >= '0') && (line[pos] <= '9') && (deadband <= 255)) {
+                deadband = deadband * 10 + line[pos] - '0';
+                pos++;
+            }
+            if ((ch <= CHANNELS_NROF) && (pos > 2) && (line[pos] == 0) && (deadband <= 255)) {
+                settings.deadband[ch] = deadband;
+                report_force |= 1 << ch;
+                result = CR;
+            }
+        }
+            break;
+        case 'Y': // Set heartbeat interval of deadband reporting (REPORT_HEARTBEAT_xxx)
+        {
+            unsigned char heartbeat = line[1] - '0';
+            if (heartbeat < REPORT_HEARTBEAT_NROF) {
+                settings.heartbeat = heartbeat;
+                result = CR;
+            }
+        }
+            break;
+        case 'I': // Set I2C bus clock
+        {
+            unsigned char speed = line[1] - '0';
+            if (i2c_setSpeed(speed)) {
+                settings.i2cspeed = speed;
+                result = CR;
+            }
+        }
+            break;
+        case 'E': // Get error counters (MCP3424, MCP9800, I2C bus recoveries, UART send overflows)
+        {
+            print_ch('E');
+            print_hex(mcp3424_errors);
+            print_hex(mcp9800_errors);
+            print_hex(i2c_recoveries);
+            print_hex(uart_txoverflow);
+            result = CR;
+        }
+            break;
+        case 'U': // Get USB send statistics (dropped frames and replies, buffer high-water mark)
+        {
+            print_ch('U');
+            print_hex(usb_txdropped);
+            print_hex(usb_txhighwater);
+            result = CR;
+        }
+            break;
+        case 'H': // Dump sample history (byte count, dropped records, ms of newest record, ms covered), the blocks follow the reply on USB
+        {
+            if (print_usb) {
+                unsigned long span = history_getSpan();
+                print_ch('H');
+                print_hex(history_dumpStart());
+                print_hex(history_lost);
+                print_hex(history_lasttime >> 16);
+                print_hex(history_lasttime);
+                print_hex(span >> 16);
+                print_hex(span);
+                result = CR;
+            }
+        }
+            break;
+        case 'L': // Set log interval (LOGGER_INTERVAL_xxx, 0 or at least LOGGER_INTERVAL_MIN), writes the pending log block
+        {
+            if (logger_setInterval(line[1] - '0')) result = CR;
+        }
+            break;
+        case 'l': // Read log (byte count), the blocks follow the reply on USB
+        {
+            if (print_usb) {
+                print_ch('l');
+                print_hex(logger_dumpStart());
+                result = CR;
+            }
+        }
+            break;
+        case 'W': // Write settings to flash
+        {
+            settings_save();
+            result = CR;
+        }
+            break;
     }
 
     print_ch(result);
+    usb_txCommit();
+}
+
+/**
+ * @brief Append character to line buffer
+ *
+ * Line feeds are dropped, characters beyond the buffer size overwrite the
+ * last one.
+ *
+ * @param ch Character to append
+ * @param line Line buffer
+ * @param linepos Fill level of line buffer
+ */
+void line_append(char ch, char * line, unsigned char * linepos) {
+    if (ch == LR) return;
+    line[*linepos] = ch;
+    if (*linepos < LINE_MAXLEN - 1) (*linepos)++;
+}
+
+/**
+ * @brief Parse received block for commands
+ *
+ * Commands which are complete within the block are parsed in place, so
+ * the block is modified. Only a command continuing in the next block is
+ * collected in the line buffer.
+ *
+ * @param data Received characters
+ * @param length Count of received characters
+ * @param line Line buffer for command spanning blocks
+ * @param linepos Fill level of line buffer
+ */
+void parseBlock(char * data, unsigned char length, char * line, unsigned char * linepos) {
+
+    unsigned char start = 0;
+    unsigned char i;
+
+    for (i = 0; i < length; i++) {
+
+        if (data[i] != CR) continue;
+
+        if (*linepos == 0) {
+            data[i] = 0;
+            // skip line feed of previous line end
+            while (data[start] == LR) start++;
+            parseLine(&data[start]);
+        } else {
+            while (start < i) line_append(data[start++], line, linepos);
+            line[*linepos] = 0;
+            parseLine(line);
+            *linepos = 0;
+        }
+
+        start = i + 1;
+    }
+
+    while (start < length) line_append(data[start++], line, linepos);
 }
 
 /**
@@ -146,10 +796,18 @@ int main(int argc, char** argv) {
     TRISC = 0b00100011;
 
     // initialize software modules
+    settings_load();
     clock_init();
     uart_init();
+    uart_setBaudrate(settings.baudrate);
     usb_init();
     i2c_init();
+    i2c_setSpeed(settings.i2cspeed);
+    logger_init();
+
+    scan_restart();
+
+    bench_run();
 
     // enable interrupts
     PEIE = 1; // peripheral interrupt enable
@@ -164,89 +822,176 @@ int main(int argc, char** argv) {
     // main loop
     while (1) {
 
+        BENCH_MARK(BENCH_ID_LOOP);
+
         // reset / bootloader
         if (!PORTAbits.RA3) {
             usb_shutdown();
-            asm("ljmp 0x000");
+            HAL_RESET();
         }
 
         // do module processing
-        usb_process();
+        i2c_process();
+        uart_process();
+        history_dumpProcess();
+        logger_process();
+
+        // keep the pending log records, the power may be cut next
+        if (usb_checkSuspend()) logger_flush();
 
         // handle main state machine
+        unsigned char result;
         switch (state) {
 
             case STATE_TRIGGER:
-                mcp3424_triggerConversation(channel);
+                if (continuous) {
+                    // start continuous conversion on selected channel
+                    channel = continuous - 1;
+                    if (mcp3424_triggerConversation(channel_mapping[channel], settings.adcconfig[channel] | MCP3424_CONFIG_CONTINUOUS) != MCP3424_BUSY) {
+                        // compensate from the start with the last ambient conversion
+                        ambient_phase = AMBIENT_PHASE_READ;
+                        state = STATE_CONTINUOUS;
+                    }
+                    break;
+                }
 
-                if (channel == 0) mcp9800_setConfig(MCP9800_CONFIG_STANDBY);
-                if (channel == 2) mcp9800_setConfig(MCP9800_CONFIG_TRIGGER);
+                result = mcp3424_triggerConversation(channel_mapping[channel], settings.adcconfig[channel]);
+                if (result == MCP3424_BUSY) break;
 
-                state = STATE_WAIT;
-                state_laststamp = clock_tickerSlow;
+                if (result == MCP3424_OK) {
+                    state = STATE_WAIT;
+                    state_laststamp = clock_tickerSlow;
+                } else {
+                    // fail fast, don't wait for a conversion which wasn't started
+                    valid &= ~(1 << channel);
+                    stamp[channel] = clock_getMillis();
+                    state = STATE_READ;
+                }
                 break;
 
             case STATE_WAIT:
-                if (clock_diff(state_laststamp) > 30) {
-                    state = STATE_READ;
+                if (settings.adcpolling) {
+                    // read as soon as ready bit is cleared, give up after twice the nominal time
+                    result = mcp3424_readConversationResult(&emf[channel], settings.adcconfig[channel]);
+                    if (result == MCP3424_BUSY) break;
+                    if ((result == MCP3424_NOTREADY) &&
+                            (clock_diff(state_laststamp) <= 2 * mcp3424_getConversionTicks(settings.adcconfig[channel]))) break;
+                } else {
+                    if (clock_diff(state_laststamp) <= mcp3424_getConversionTicks(settings.adcconfig[channel])) break;
+                    result = mcp3424_readConversationResult(&emf[channel], settings.adcconfig[channel]);
+                    if (result == MCP3424_BUSY) break;
+                }
+
+                if (result == MCP3424_OK) {
+                    emf[channel] = filter_apply(channel, emf[channel]);
+                    valid |= 1 << channel;
+                } else {
+                    valid &= ~(1 << channel);
                 }
+                stamp[channel] = clock_getMillis();
+                state = STATE_READ;
                 break;
 
             case STATE_READ:
 
-                mcp3424_readConversationResult(&temperature[channel]);
-
                 channel++;
+                scan_skipDisabledChannels();
                 if (channel == CHANNELS_NROF) {
+                    state = STATE_AMBIENT;
+                } else {
+                    state = STATE_TRIGGER;
+                }
+                break;
+
+            case STATE_AMBIENT:
+                // ambient conversion was triggered at end of last scan
+                result = mcp9800_getTemperature(&ambient);
+                if (result == MCP9800_BUSY) break;
 
-                    signed short ambitemp;
-                    mcp9800_getTemperature(&ambitemp);
+                if (result == MCP9800_OK) valid |= FRAME_MASK_AMBIENT;
+                else valid &= ~FRAME_MASK_AMBIENT;
+                stamp[CHANNELS_NROF] = clock_getMillis();
+                state = STATE_AMBIENT_TRIGGER;
+                break;
 
-                    print_ch(' ');
+            case STATE_AMBIENT_TRIGGER:
+                if (mcp9800_setConfig(MCP9800_CONFIG_TRIGGER) != MCP9800_BUSY) {
 
                     unsigned char i;
                     for (i = 0; i < CHANNELS_NROF; i++) {
-                        if (i) print_str((char*) ", ");
-                        print_degree(ambitemp + temperature[channel_mapping[i]]);
+                        if (valid & (1 << i)) compensate(i);
                     }
 
-                    print_str((char*) ", ");
-                    print_degree(ambitemp);
-                    print_ch(CR);
+                    unsigned char mask = settings.channelmask | FRAME_MASK_AMBIENT;
+                    unsigned char report = report_select(mask);
+                    if (report) {
+                        frame_omitted = mask & ~report;
+                        print_frame(report);
+                        frame_omitted = 0;
+
+                        // report again if the frame didn't reach the host
+                        if (!print_usb && usb_isOpen()) report_force |= report;
+                    }
+
+                    int24_t values[CHANNELS_NROF + 1];
+                    for (i = 0; i <= CHANNELS_NROF; i++) {
+                        values[i] = value_get(i);
+                    }
+                    history_add(settings.channelmask | FRAME_MASK_AMBIENT, values);
+                    logger_add(settings.channelmask | FRAME_MASK_AMBIENT, values);
 
-                    channel = 0;
+                    scan_checkOverrun();
+                    scan_restart();
                 }
-                state = STATE_TRIGGER;
                 break;
-        }
 
-        if (usb_chReceived()) {
+            case STATE_IDLE:
+                if ((signed long) (clock_getMillis() - scan_deadline) < 0) break;
 
-            unsigned char ch = usb_getch();
+                scan_deadline += scan_intervals[settings.scaninterval];
+                state = STATE_TRIGGER;
+                break;
 
-            if (ch == CR) {
-                line_usb[linepos_usb] = 0;
-                parseLine(line_usb);
-                linepos_usb = 0;
-            } else if (ch != LR) {
-                line_usb[linepos_usb] = ch;
-                if (linepos_usb < LINE_MAXLEN - 1) linepos_usb++;
-            }
+            case STATE_CONTINUOUS:
+                // refresh ambient periodically, the scan doesn't do it here
+                if (ambient_phase == AMBIENT_PHASE_READ) {
+                    result = mcp9800_getTemperature(&ambient);
+                    if (result != MCP9800_BUSY) {
+                        if (result == MCP9800_OK) valid |= FRAME_MASK_AMBIENT;
+                        else valid &= ~FRAME_MASK_AMBIENT;
+                        stamp[CHANNELS_NROF] = clock_getMillis();
+                        ambient_phase = AMBIENT_PHASE_TRIGGER;
+                    }
+                } else if (ambient_phase == AMBIENT_PHASE_TRIGGER) {
+                    if (mcp9800_setConfig(MCP9800_CONFIG_TRIGGER) != MCP9800_BUSY) {
+                        ambient_laststamp = clock_tickerSlow;
+                        ambient_phase = AMBIENT_PHASE_WAIT;
+                    }
+                } else if (clock_diff(ambient_laststamp) > AMBIENT_REFRESH_TICKS) {
+                    ambient_phase = AMBIENT_PHASE_READ;
+                }
 
+                // stream every new result as soon as it is ready
+                if (mcp3424_readConversationResult(&emf[channel], settings.adcconfig[channel]) == MCP3424_OK) {
+                    emf[channel] = filter_apply(channel, emf[channel]);
+                    valid |= 1 << channel;
+                    stamp[channel] = clock_getMillis();
+                    compensate(channel);
+                    print_frame(1 << channel);
+                }
+                break;
         }
 
-        if (uart_chReceived()) {
-
-            unsigned char ch = uart_getch();
+        char * block;
+        unsigned char length = usb_getBlock(&block);
+        if (length) {
+            parseBlock(block, length, line_usb, &linepos_usb);
+            usb_releaseBlock();
+        }
 
-            if (ch == CR) {
-                line_uart[linepos_uart] = 0;
-                parseLine(line_uart);
-                linepos_uart = 0;
-            } else if (ch != LR) {
-                line_uart[linepos_uart] = ch;
-                if (linepos_uart < LINE_MAXLEN - 1) linepos_uart++;
-            }
+        if (uart_chReceived()) {
+            char ch = uart_getch();
+            parseBlock(&ch, 1, line_uart, &linepos_uart);
         }
     };
 
@@ -258,11 +1003,26 @@ int main(int argc, char** argv) {
  */
 void interrupt isr(void) {
 
-    // timer 1 interrupt
-    if (TMR1IE && TMR1IF) {
-        TMR1IF = 0;
+    // timer 2 interrupt
+    if (TMR2IE && TMR2IF) {
+        TMR2IF = 0;
 
         clock_isr();
     }
 
+    // usb interrupt
+    if (USBIE && USBIF) {
+        usb_isr();
+    }
+
+    // i2c interrupt
+    if ((SSP1IE && SSP1IF) || (BCL1IE && BCL1IF)) {
+        i2c_isr();
+    }
+
+    // uart transmit interrupt
+    if (TXIE && TXIF) {
+        uart_txisr();
+    }
+
 }
\ No newline at end of file
@@ -25,52 +25,145 @@
 #include "thermosera.h"
 #include "mcp3424.h"
 
+I2C_TRANSACTION mcp3424_transaction;
+unsigned char mcp3424_buffer[4];
+unsigned char mcp3424_operation = MCP3424_OPERATION_NONE;
+unsigned short mcp3424_errors = 0;
+
+// conversion time in clock ticks (10 ms) incl. 10% oscillator tolerance,
+// waiting for more than this count of ticks covers the tick granularity
+const unsigned char mcp3424_conversionTicks[] = {
+    1, // 12 bit, 4.2 ms
+    2, // 14 bit, 16.7 ms
+    8, // 16 bit, 66.7 ms
+    30 // 18 bit, 266.7 ms
+};
+
+/**
+ * @brief Get conversion time for given configuration
+ * @param config Resolution and gain configuration
+ * @return Count of clock ticks to wait for conversion result
+ */
+unsigned char mcp3424_getConversionTicks(unsigned char config) {
+    return mcp3424_conversionTicks[(config & MCP3424_CONFIG_RESOLUTION_MASK) >> MCP3424_CONFIG_RESOLUTION_SHIFT];
+}
+
+/**
+ * @brief Discard trigger or result of the last transaction
+ *
+ * The next call of mcp3424_triggerConversation() or
+ * mcp3424_readConversationResult() starts a new transaction, even if the
+ * last one with the same configuration is finished but not taken yet.
+ */
+void mcp3424_discard() {
+    mcp3424_operation = MCP3424_OPERATION_NONE;
+}
+
 /**
  * @brief Trigger conversation
+ *
+ * The configuration is written in background. Call again until the result
+ * isn't MCP3424_BUSY anymore.
+ *
  * @param channel Channel to start conversation
- * @retval 1 Successful
- * @retval 0 Error while triggering conversation
+ * @param config Resolution and gain configuration, optionally with
+ *        MCP3424_CONFIG_CONTINUOUS for continuous conversion mode
+ * @retval MCP3424_OK Successful
+ * @retval MCP3424_BUSY Transaction in progress
+ * @retval MCP3424_ERROR Error while triggering conversation
  */
-unsigned char mcp3424_triggerConversation(unsigned char channel) {
+unsigned char mcp3424_triggerConversation(unsigned char channel, unsigned char config) {
     
-    if (!i2c_start()) return 0;
-    if (!i2c_sendByte(MCP3424_I2C_ADDRESS)) return 0;
-    if (!i2c_sendByte(0b10001111 | (channel << 5))) return 0;                
-    if (!i2c_stop()) return 0;
+    config &= MCP3424_CONFIG_CONTINUOUS | MCP3424_CONFIG_RESOLUTION_MASK | MCP3424_CONFIG_GAIN_MASK;
+    config |= MCP3424_CONFIG_RDY | (channel << MCP3424_CONFIG_CHANNEL_SHIFT);
+
+    if (mcp3424_transaction.status == I2C_STATUS_PENDING) return MCP3424_BUSY;
+
+    if ((mcp3424_transaction.status != I2C_STATUS_IDLE) &&
+            (mcp3424_operation == MCP3424_OPERATION_TRIGGER) && (mcp3424_buffer[0] == config)) {
+        if (i2c_finish(&mcp3424_transaction) == I2C_STATUS_DONE) return MCP3424_OK;
+        mcp3424_errors++;
+        return MCP3424_ERROR;
+    }
+
+    mcp3424_operation = MCP3424_OPERATION_TRIGGER;
+    mcp3424_buffer[0] = config;
+    mcp3424_transaction.address = MCP3424_I2C_ADDRESS;
+    mcp3424_transaction.data = mcp3424_buffer;
+    mcp3424_transaction.writelength = 1;
+    mcp3424_transaction.readlength = 0;
+    if (!i2c_enqueue(&mcp3424_transaction)) {
+        mcp3424_errors++;
+        return MCP3424_ERROR;
+    }
     
-    return 1;
+    return MCP3424_BUSY;
 }
 
 /**
  * @brief Read conversation result
- * @param data Pointer to result
- * @retval 1 Succsessful
- * @retval 0 Error while reading result
+ *
+ * The result is read in background. Call again until the result isn't
+ * MCP3424_BUSY anymore.
+ *
+ * The ADC repeats the MSB in the unused upper bits, so the 16 bit result
+ * (12/14/16 bit modes) and the 24 bit result (18 bit mode) are already sign
+ * extended. One LSB is 15.625uV / gain at 18 bit and 4 times more for each
+ * lower resolution step, the value is scaled to uV.
+ *
+ * The configuration byte following the data bytes is read as well. If its
+ * /RDY bit is still set, the conversation isn't finished yet and the given
+ * result is left untouched.
+ *
+ * @param data Pointer to result (uV)
+ * @param config Resolution and gain configuration used for conversation
+ * @retval MCP3424_OK Succsessful
+ * @retval MCP3424_NOTREADY Conversation not finished yet
+ * @retval MCP3424_BUSY Transaction in progress
+ * @retval MCP3424_ERROR Error while reading result
  */
-unsigned char mcp3424_readConversationResult(signed short long * data) {
+unsigned char mcp3424_readConversationResult(int24_t * data, unsigned char config) {
     
-    *data = 0;
-    
-    if (!i2c_start()) return 0;
+    unsigned char resolution = (config & MCP3424_CONFIG_RESOLUTION_MASK) >> MCP3424_CONFIG_RESOLUTION_SHIFT;
+    unsigned char count = 2;
+    if (resolution == MCP3424_RESOLUTION_18BIT) count = 3;
 
-    if (!i2c_sendByte(MCP3424_I2C_ADDRESS | 1)) return 0;
-    
-    unsigned char i;
-    for (i = 0; i < 3; i++) {
+    if (mcp3424_transaction.status == I2C_STATUS_PENDING) return MCP3424_BUSY;
 
-        unsigned char b;
-        if (!i2c_receiveByte(&b, (i==2))) return 0;
+    if ((mcp3424_transaction.status == I2C_STATUS_IDLE) || (mcp3424_operation != MCP3424_OPERATION_READ)) {
+
+        // data bytes followed by configuration byte
+        mcp3424_operation = MCP3424_OPERATION_READ;
+        mcp3424_transaction.address = MCP3424_I2C_ADDRESS;
+        mcp3424_transaction.data = mcp3424_buffer;
+        mcp3424_transaction.writelength = 0;
+        mcp3424_transaction.readlength = count + 1;
+        if (!i2c_enqueue(&mcp3424_transaction)) {
+            mcp3424_errors++;
+            return MCP3424_ERROR;
+        }
+
+        return MCP3424_BUSY;
+    }
+
+    if (i2c_finish(&mcp3424_transaction) != I2C_STATUS_DONE) {
+        mcp3424_errors++;
+        return MCP3424_ERROR;
+    }
+
+    if (mcp3424_buffer[count] & MCP3424_CONFIG_RDY) return MCP3424_NOTREADY;
+
+    // first byte carries the sign
+    signed long cal = (signed char) mcp3424_buffer[0];
+    unsigned char i;
+    for (i = 1; i < count; i++) {
+        cal = (cal << 8) | mcp3424_buffer[i];
+    }
 
-        *data = (*data << 8) | b;
-    }    
-    
-    if (!i2c_stop()) return 0;
-    
-    signed long cal = *data;
     cal = cal * 1000;
-    //cal = cal / 2048;
-    cal = cal >> 11;
+    // 12 bit, gain 1: 1000uV / 1; 18 bit, gain 8: 1000uV / 512
+    cal = cal >> ((resolution << 1) + (config & MCP3424_CONFIG_GAIN_MASK));
     *data = cal;
     
-    return 1;
+    return MCP3424_OK;
 }
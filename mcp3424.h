@@ -24,9 +24,47 @@
 #ifndef MCP3424_H
 #define	MCP3424_H
 
-unsigned char mcp3424_triggerConversation(unsigned char channel);
-unsigned char mcp3424_readConversationResult(signed short long * data);
+unsigned char mcp3424_triggerConversation(unsigned char channel, unsigned char config);
+unsigned char mcp3424_readConversationResult(int24_t * data, unsigned char config);
+unsigned char mcp3424_getConversionTicks(unsigned char config);
+void mcp3424_discard();
+
+extern unsigned short mcp3424_errors;
 
 #define MCP3424_I2C_ADDRESS 0b11010000
 
+/* Return values */
+#define MCP3424_ERROR 0
+#define MCP3424_OK 1
+#define MCP3424_NOTREADY 2
+#define MCP3424_BUSY 3
+
+/* Operation of background transaction */
+#define MCP3424_OPERATION_TRIGGER 0
+#define MCP3424_OPERATION_READ 1
+#define MCP3424_OPERATION_NONE 2 // last transaction discarded
+
+/* Configuration register bits */
+#define MCP3424_CONFIG_RDY 0x80
+#define MCP3424_CONFIG_CHANNEL_SHIFT 5
+#define MCP3424_CONFIG_CONTINUOUS 0x10
+#define MCP3424_CONFIG_RESOLUTION_SHIFT 2
+#define MCP3424_CONFIG_RESOLUTION_MASK 0x0C
+#define MCP3424_CONFIG_GAIN_MASK 0x03
+
+/* Sample rate / resolution selection (S1 S0) */
+#define MCP3424_RESOLUTION_12BIT 0 // 240 SPS
+#define MCP3424_RESOLUTION_14BIT 1 // 60 SPS
+#define MCP3424_RESOLUTION_16BIT 2 // 15 SPS
+#define MCP3424_RESOLUTION_18BIT 3 // 3.75 SPS
+
+/* PGA gain selection (G1 G0) */
+#define MCP3424_GAIN_1 0
+#define MCP3424_GAIN_2 1
+#define MCP3424_GAIN_4 2
+#define MCP3424_GAIN_8 3
+
+#define MCP3424_CONFIG(resolution, gain) (((resolution) << MCP3424_CONFIG_RESOLUTION_SHIFT) | (gain))
+#define MCP3424_CONFIG_DEFAULT MCP3424_CONFIG(MCP3424_RESOLUTION_18BIT, MCP3424_GAIN_8)
+
 #endif
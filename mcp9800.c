@@ -26,57 +26,93 @@
 #include "thermosera.h"
 #include "mcp9800.h"
 
+#define MCP9800_OPERATION_CONFIG 0
+#define MCP9800_OPERATION_TEMPERATURE 1
+
+I2C_TRANSACTION mcp9800_transaction;
+unsigned char mcp9800_buffer[2];
+unsigned char mcp9800_operation;
+unsigned short mcp9800_errors = 0;
+
 /**
  * @brief Set configuration register
+ *
+ * The register is written in background. Call again until the result isn't
+ * MCP9800_BUSY anymore.
+ *
  * @param config Configuration value
- * @retval 1 Successful
- * @retval 0 Error while setting configuration register
+ * @retval MCP9800_OK Successful
+ * @retval MCP9800_BUSY Transaction in progress
+ * @retval MCP9800_ERROR Error while setting configuration register
  */
 unsigned char mcp9800_setConfig(unsigned char config) {
     
-    if (!i2c_start()) return 0;
-    if (!i2c_sendByte(MCP9800_I2C_ADDRESS)) return 0;
-    if (!i2c_sendByte(MCP9800_REG_CONFIG)) return 0;
-    if (!i2c_sendByte(config)) return 0;
-    if (!i2c_stop()) return 0;
-    return 1;
+    if (mcp9800_transaction.status == I2C_STATUS_PENDING) return MCP9800_BUSY;
+
+    if ((mcp9800_transaction.status != I2C_STATUS_IDLE) &&
+            (mcp9800_operation == MCP9800_OPERATION_CONFIG) && (mcp9800_buffer[1] == config)) {
+        if (i2c_finish(&mcp9800_transaction) == I2C_STATUS_DONE) return MCP9800_OK;
+        mcp9800_errors++;
+        return MCP9800_ERROR;
+    }
+
+    mcp9800_operation = MCP9800_OPERATION_CONFIG;
+    mcp9800_buffer[0] = MCP9800_REG_CONFIG;
+    mcp9800_buffer[1] = config;
+    mcp9800_transaction.address = MCP9800_I2C_ADDRESS;
+    mcp9800_transaction.data = mcp9800_buffer;
+    mcp9800_transaction.writelength = 2;
+    mcp9800_transaction.readlength = 0;
+    if (!i2c_enqueue(&mcp9800_transaction)) {
+        mcp9800_errors++;
+        return MCP9800_ERROR;
+    }
+
+    return MCP9800_BUSY;
 }
 
 /**
  * @brief Get temperature
+ *
+ * The register is read in background. Call again until the result isn't
+ * MCP9800_BUSY anymore.
+ *
  * @param data Pointer to temperature variable
- * @retval 1 Successful
- * @retval 0 Error while reading temperature
+ * @retval MCP9800_OK Successful
+ * @retval MCP9800_BUSY Transaction in progress
+ * @retval MCP9800_ERROR Error while reading temperature
  */
 unsigned char mcp9800_getTemperature(signed short * data) {
     
-    *data = 0;
-    
-    if (!i2c_start()) return 0;
-    if (!i2c_sendByte(MCP9800_I2C_ADDRESS)) return 0;
-    if (!i2c_sendByte(MCP9800_REG_DATA)) return 0;
-    if (!i2c_stop()) return 0;
-    
-    if (!i2c_start()) return 0;
-    if (!i2c_sendByte(MCP9800_I2C_ADDRESS | 1)) return 0;
-    
-    unsigned char i;
-    for (i = 0; i < 2; i++) {
+    if (mcp9800_transaction.status == I2C_STATUS_PENDING) return MCP9800_BUSY;
 
-        unsigned char b;
-        if (!i2c_receiveByte(&b, (i==1))) return 0;
+    if ((mcp9800_transaction.status == I2C_STATUS_IDLE) || (mcp9800_operation != MCP9800_OPERATION_TEMPERATURE)) {
 
-        *data = (*data << 8) | b;
-    }    
-    
-    if (!i2c_stop()) return 0;
+        // set register pointer, then read with repeated start
+        mcp9800_operation = MCP9800_OPERATION_TEMPERATURE;
+        mcp9800_buffer[0] = MCP9800_REG_DATA;
+        mcp9800_transaction.address = MCP9800_I2C_ADDRESS;
+        mcp9800_transaction.data = mcp9800_buffer;
+        mcp9800_transaction.writelength = 1;
+        mcp9800_transaction.readlength = 2;
+        if (!i2c_enqueue(&mcp9800_transaction)) {
+            mcp9800_errors++;
+            return MCP9800_ERROR;
+        }
+
+        return MCP9800_BUSY;
+    }
+
+    if (i2c_finish(&mcp9800_transaction) != I2C_STATUS_DONE) {
+        mcp9800_errors++;
+        return MCP9800_ERROR;
+    }
     
-    signed long cal = *data;
+    signed long cal = (signed short) ((mcp9800_buffer[0] << 8) | mcp9800_buffer[1]);
     cal = cal * 10;
     //cal = cal / 2048;
     cal = cal >> 8;
     *data = cal;
     
-    return 1;
+    return MCP9800_OK;
 }
-
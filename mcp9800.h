@@ -27,6 +27,13 @@
 unsigned char mcp9800_setConfig(unsigned char config);
 unsigned char mcp9800_getTemperature(signed short * data);
 
+/* Return values */
+#define MCP9800_ERROR 0
+#define MCP9800_OK 1
+#define MCP9800_BUSY 2
+
+extern unsigned short mcp9800_errors;
+
 #define MCP9800_I2C_ADDRESS 0b10010000
 #define MCP9800_REG_CONFIG 0x01
 #define MCP9800_REG_DATA 0x00
@@ -0,0 +1,127 @@
+/**
+ * @file settings.c
+ *
+ * @brief This file contains the persistent settings routines for the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "uart.h"
+#include "i2c.h"
+#include "mcp3424.h"
+#include "thermocouple.h"
+#include "logger.h"
+#include "filter.h"
+#include "settings.h"
+
+// reserve flash row, so the linker doesn't place code there
+const unsigned char settings_flash[FLASH_ROWSIZE] HAL_AT(SETTINGS_FLASH_ADDRESS) = {0xff};
+
+SETTINGS settings;
+
+// compile time check, fails with negative array size if settings don't fit into a row
+typedef char settings_sizecheck[(sizeof (SETTINGS) <= FLASH_ROWSIZE) ? 1 : -1];
+
+/**
+ * @brief Set all settings to default values
+ */
+void settings_setDefaults() {
+    settings.magic = SETTINGS_MAGIC;
+    settings.size = sizeof (SETTINGS);
+    settings.baudrate = UART_BAUDRATE_9600;
+    settings.outputformat = OUTPUT_FORMAT_ASCII;
+    settings.decimals = VALUE_DECIMALS;
+    settings.timestamps = 0;
+    settings.channelmask = FRAME_MASK_CHANNELS;
+
+    unsigned char i;
+    for (i = 0; i < CHANNELS_NROF; i++) {
+        settings.adcconfig[i] = MCP3424_CONFIG_DEFAULT;
+        settings.tctype[i] = THERMOCOUPLE_TYPE_K;
+        settings.filtertype[i] = FILTER_TYPE_NONE;
+        settings.filterparam[i] = 0;
+    }
+    settings.adcpolling = 1;
+    settings.i2cspeed = I2C_SPEED_400KHZ;
+    settings.loginterval = LOGGER_INTERVAL_OFF;
+    settings.scaninterval = SCAN_INTERVAL_FREE;
+    for (i = 0; i <= CHANNELS_NROF; i++) {
+        settings.deadband[i] = 0;
+    }
+    settings.heartbeat = REPORT_HEARTBEAT_OFF;
+}
+
+/**
+ * @brief Check range of all settings
+ *
+ * The settings are used as table indices, so a corrupted or foreign flash
+ * row must not get through.
+ *
+ * @retval 1 All settings valid
+ * @retval 0 At least one setting out of range
+ */
+unsigned char settings_valid() {
+
+    if ((settings.magic != SETTINGS_MAGIC) || (settings.size != sizeof (SETTINGS))) return 0;
+
+    if (settings.baudrate >= UART_BAUDRATE_NROF) return 0;
+    if (settings.outputformat > OUTPUT_FORMAT_BINARY) return 0;
+    if (settings.decimals > VALUE_DECIMALS) return 0;
+    if (settings.timestamps > 1) return 0;
+    if ((settings.channelmask == 0) || (settings.channelmask > FRAME_MASK_CHANNELS)) return 0;
+    if (settings.adcpolling > 1) return 0;
+    if (settings.i2cspeed >= I2C_SPEED_NROF) return 0;
+    if (settings.loginterval >= LOGGER_INTERVAL_NROF) return 0;
+    if ((settings.loginterval != LOGGER_INTERVAL_OFF) && (settings.loginterval < LOGGER_INTERVAL_MIN)) return 0;
+    if (settings.scaninterval >= SCAN_INTERVAL_NROF) return 0;
+    if (settings.heartbeat >= REPORT_HEARTBEAT_NROF) return 0;
+
+    unsigned char i;
+    for (i = 0; i < CHANNELS_NROF; i++) {
+        if (settings.adcconfig[i] & ~(MCP3424_CONFIG_RESOLUTION_MASK | MCP3424_CONFIG_GAIN_MASK)) return 0;
+        if (settings.tctype[i] >= THERMOCOUPLE_TYPE_NROF) return 0;
+        // applies the loaded filter if valid
+        if (!filter_set(i, settings.filtertype[i], settings.filterparam[i])) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Load settings from flash, fall back to defaults if invalid
+ */
+void settings_load() {
+
+    unsigned char * p = (unsigned char *) &settings;
+    unsigned char i;
+    for (i = 0; i < sizeof (SETTINGS); i++) {
+        p[i] = flash_read(SETTINGS_FLASH_ADDRESS + i);
+    }
+
+    if (!settings_valid()) {
+        settings_setDefaults();
+    }
+}
+
+/**
+ * @brief Store current settings to flash
+ */
+void settings_save() {
+    flash_writeRow(SETTINGS_FLASH_ADDRESS, (unsigned char *) &settings, sizeof (SETTINGS));
+}
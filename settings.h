@@ -0,0 +1,63 @@
+/**
+ * @file settings.h
+ *
+ * @brief This file contains the definitions for the persistent settings of
+ *        the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef SETTINGS_H
+#define	SETTINGS_H
+
+#include "thermosera.h"
+#include "flash.h"
+
+#define SETTINGS_FLASH_ADDRESS FLASH_HEF_ADDRESS
+#define SETTINGS_MAGIC 0xA5
+
+/*
+ * The settings are stored in a single flash row, so they must not exceed
+ * FLASH_ROWSIZE bytes (checked in settings.c).
+ */
+typedef struct
+{
+    unsigned char magic;
+    unsigned char size;
+    unsigned char baudrate;
+    unsigned char outputformat;
+    unsigned char decimals;
+    unsigned char timestamps;
+    unsigned char channelmask;
+    unsigned char adcconfig[CHANNELS_NROF];
+    unsigned char adcpolling;
+    unsigned char i2cspeed;
+    unsigned char tctype[CHANNELS_NROF];
+    unsigned char loginterval;
+    unsigned char filtertype[CHANNELS_NROF];
+    unsigned char filterparam[CHANNELS_NROF];
+    unsigned char deadband[CHANNELS_NROF + 1]; // 0.1 degree, incl. ambient
+    unsigned scaninterval : 4; // SCAN_INTERVAL_xxx
+    unsigned heartbeat : 4; // REPORT_HEARTBEAT_xxx
+} SETTINGS;
+
+void settings_load();
+void settings_save();
+
+extern SETTINGS settings;
+
+#endif
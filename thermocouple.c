@@ -0,0 +1,201 @@
+/**
+ * @file thermocouple.c
+ *
+ * @brief This file contains the thermocouple linearization routines for the
+ *        THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#include "thermosera.h"
+#include "thermocouple.h"
+
+/*
+ * Breakpoints of the NIST ITS-90 reference functions. The points are placed
+ * so that linear interpolation between them stays within 0.2 degree of the
+ * reference function. The thermoelectric voltage of type B is not monotonic
+ * below 21 degree and negligible up to 250 degree, there the points are set
+ * for cold junction compensation (within 1.5 uV).
+ */
+
+// type K, -200..1372 degree
+const THERMOCOUPLE_POINT thermocouple_tableK[] = {
+    {-2000, -5891}, {-1880, -5695}, {-1750, -5454}, {-1610, -5163},
+    {-1460, -4817}, {-1300, -4411}, {-1120, -3911}, {-930, -3337},
+    {-720, -2654}, {-480, -1818}, {-210, -816}, {120, 477}, {580, 2354},
+    {1320, 5410}, {2510, 10194}, {3210, 13081}, {4190, 17201}, {6560, 27278},
+    {7470, 31089}, {8290, 34460}, {9090, 37686}, {9870, 40768}, {10620, 43672},
+    {11320, 46324}, {11970, 48729}, {12580, 50929}, {13170, 53002},
+    {13720, 54886}
+};
+
+// type J, -210..1200 degree
+const THERMOCOUPLE_POINT thermocouple_tableJ[] = {
+    {-2100, -8095}, {-2000, -7890}, {-1880, -7610}, {-1750, -7265},
+    {-1610, -6853}, {-1450, -6332}, {-1270, -5690}, {-1070, -4917},
+    {-850, -4002}, {-600, -2893}, {-310, -1530}, {20, 101}, {420, 2164},
+    {930, 4889}, {1690, 9060}, {3700, 20194}, {4920, 26945}, {5570, 30616},
+    {6110, 33748}, {6620, 36797}, {7130, 39943}, {7730, 43752}, {8670, 49799},
+    {9210, 53181}, {9750, 56464}, {10390, 60248}, {11560, 67025},
+    {12000, 69553}
+};
+
+// type T, -200..400 degree
+const THERMOCOUPLE_POINT thermocouple_tableT[] = {
+    {-2000, -5603}, {-1870, -5387}, {-1730, -5128}, {-1580, -4823},
+    {-1420, -4466}, {-1250, -4052}, {-1070, -3574}, {-880, -3030},
+    {-670, -2380}, {-450, -1648}, {-220, -830}, {30, 117}, {310, 1238},
+    {590, 2425}, {880, 3722}, {1200, 5228}, {1540, 6905}, {1910, 8812},
+    {2300, 10907}, {2720, 13253}, {3180, 15914}, {3660, 18786}, {4000, 20872}
+};
+
+// type E, -200..1000 degree
+const THERMOCOUPLE_POINT thermocouple_tableE[] = {
+    {-2000, -8825}, {-1870, -8477}, {-1730, -8059}, {-1580, -7563},
+    {-1410, -6945}, {-1230, -6232}, {-1030, -5372}, {-820, -4398},
+    {-590, -3255}, {-340, -1929}, {-70, -408}, {250, 1495}, {580, 3556},
+    {920, 5781}, {1290, 8309}, {1700, 11224}, {2170, 14687}, {2720, 18867},
+    {3380, 24016}, {4230, 30791}, {6540, 49436}, {7580, 57712}, {8540, 65233},
+    {9340, 71387}, {10000, 76373}
+};
+
+// type N, -200..1300 degree
+const THERMOCOUPLE_POINT thermocouple_tableN[] = {
+    {-2000, -3990}, {-1890, -3873}, {-1770, -3728}, {-1640, -3550},
+    {-1500, -3336}, {-1350, -3084}, {-1180, -2769}, {-990, -2386},
+    {-780, -1927}, {-540, -1366}, {-250, -646}, {190, 499}, {530, 1423},
+    {870, 2392}, {1220, 3435}, {1600, 4618}, {2010, 5946}, {2460, 7460},
+    {2950, 9164}, {3500, 11136}, {4120, 13420}, {4840, 16137}, {5730, 19563},
+    {7100, 24919}, {9150, 32956}, {10290, 37373}, {11230, 40958},
+    {12080, 44144}, {12810, 46826}, {13000, 47513}
+};
+
+// type R, -50..1768 degree
+const THERMOCOUPLE_POINT thermocouple_tableR[] = {
+    {-500, -226}, {-370, -175}, {-230, -114}, {-70, -36}, {100, 54}, {290, 165},
+    {500, 296}, {720, 445}, {970, 625}, {1240, 832}, {1540, 1074}, {1870, 1355},
+    {2230, 1675}, {2630, 2046}, {3070, 2469}, {3550, 2947}, {4080, 3491},
+    {4650, 4093}, {5240, 4734}, {5850, 5414}, {6470, 6122}, {7090, 6849},
+    {7720, 7607}, {8360, 8396}, {9010, 9218}, {9680, 10085}, {10380, 11012},
+    {11130, 12027}, {12020, 13256}, {13240, 14967}, {15360, 17956},
+    {16350, 19333}, {17010, 20235}, {17380, 20724}, {17680, 21101}
+};
+
+// type S, -50..1768 degree
+const THERMOCOUPLE_POINT thermocouple_tableS[] = {
+    {-500, -236}, {-360, -177}, {-210, -108}, {-40, -21}, {150, 84}, {350, 204},
+    {570, 345}, {820, 516}, {1100, 720}, {1410, 958}, {1750, 1232},
+    {2140, 1560}, {2580, 1944}, {3080, 2396}, {3650, 2927}, {4290, 3538},
+    {4980, 4213}, {5700, 4934}, {6420, 5670}, {7130, 6412}, {7830, 7161},
+    {8530, 7926}, {9250, 8731}, {10000, 9587}, {10760, 10473}, {11690, 11578},
+    {12990, 13147}, {14990, 15570}, {16000, 16777}, {16810, 17728},
+    {17220, 18196}, {17530, 18535}, {17680, 18693}
+};
+
+// type B, 0..1820 degree
+const THERMOCOUPLE_POINT thermocouple_tableB[] = {
+    {0, 0}, {210, -3}, {500, 2}, {750, 14}, {1000, 33}, {1250, 59}, {1500, 92},
+    {1750, 132}, {2000, 178}, {2250, 231}, {2500, 291}, {2700, 344},
+    {2900, 401}, {3110, 465}, {3330, 537}, {3560, 617}, {3800, 707},
+    {4050, 807}, {4310, 917}, {4580, 1039}, {4860, 1172}, {5150, 1318},
+    {5450, 1478}, {5760, 1651}, {6080, 1839}, {6380, 2025}, {6720, 2243},
+    {7070, 2479}, {7430, 2731}, {7800, 3002}, {8180, 3292}, {8580, 3610},
+    {8990, 3949}, {9420, 4317}, {9870, 4716}, {10330, 5139}, {10810, 5595},
+    {11310, 6085}, {11830, 6611}, {12380, 7184}, {12960, 7805}, {13590, 8497},
+    {14290, 9285}, {15140, 10261}, {16800, 12199}, {17860, 13430},
+    {18200, 13820}
+};
+
+const THERMOCOUPLE_POINT * const thermocouple_tables[THERMOCOUPLE_TYPE_NROF] = {
+    thermocouple_tableK,
+    thermocouple_tableJ,
+    thermocouple_tableT,
+    thermocouple_tableE,
+    thermocouple_tableN,
+    thermocouple_tableR,
+    thermocouple_tableS,
+    thermocouple_tableB
+};
+
+const unsigned char thermocouple_tablesizes[THERMOCOUPLE_TYPE_NROF] = {
+    sizeof (thermocouple_tableK) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableJ) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableT) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableE) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableN) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableR) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableS) / sizeof (THERMOCOUPLE_POINT),
+    sizeof (thermocouple_tableB) / sizeof (THERMOCOUPLE_POINT)
+};
+
+/**
+ * @brief Get thermoelectric voltage for given temperature
+ *
+ * Used for cold junction compensation. Outside of the table range the
+ * voltage is limited to the first/last table entry.
+ *
+ * @param type Thermocouple type (THERMOCOUPLE_TYPE_xxx)
+ * @param temperature Temperature in 0.1 degree
+ * @return Thermoelectric voltage in uV
+ */
+int24_t thermocouple_getEmf(unsigned char type, int24_t temperature) {
+
+    const THERMOCOUPLE_POINT * table = thermocouple_tables[type];
+
+    // binary search for segment
+    unsigned char lo = 0;
+    unsigned char hi = thermocouple_tablesizes[type] - 1;
+    if (temperature <= table[lo].temperature) return table[lo].emf;
+    if (temperature >= table[hi].temperature) return table[hi].emf;
+    while (hi - lo > 1) {
+        unsigned char mid = (lo + hi) >> 1;
+        if (table[mid].temperature <= temperature) lo = mid;
+        else hi = mid;
+    }
+
+    signed long e = (signed long) (table[hi].emf - table[lo].emf) * (temperature - table[lo].temperature);
+    return table[lo].emf + e / (table[hi].temperature - table[lo].temperature);
+}
+
+/**
+ * @brief Get temperature for given thermoelectric voltage
+ *
+ * Outside of the table range the temperature is limited to the first/last
+ * table entry.
+ *
+ * @param type Thermocouple type (THERMOCOUPLE_TYPE_xxx)
+ * @param emf Thermoelectric voltage in uV (cold junction at 0 degree)
+ * @return Temperature in 0.1 degree
+ */
+int24_t thermocouple_getTemperature(unsigned char type, int24_t emf) {
+
+    const THERMOCOUPLE_POINT * table = thermocouple_tables[type];
+
+    // binary search for segment
+    unsigned char lo = 0;
+    unsigned char hi = thermocouple_tablesizes[type] - 1;
+    if (emf <= table[lo].emf) return table[lo].temperature;
+    if (emf >= table[hi].emf) return table[hi].temperature;
+    while (hi - lo > 1) {
+        unsigned char mid = (lo + hi) >> 1;
+        if (table[mid].emf <= emf) lo = mid;
+        else hi = mid;
+    }
+
+    signed long t = (signed long) (table[hi].temperature - table[lo].temperature) * (emf - table[lo].emf);
+    return table[lo].temperature + t / (table[hi].emf - table[lo].emf);
+}
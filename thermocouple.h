@@ -0,0 +1,49 @@
+/**
+ * @file thermocouple.h
+ *
+ * @brief This file contains the definitions for thermocouple linearization
+ *        functions for the THERMOsera firmware project
+ *
+ * @author Thomas Fischl
+ * @copyright (c) 2016 Thomas Fischl
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+#ifndef THERMOCOUPLE_H
+#define	THERMOCOUPLE_H
+
+#define THERMOCOUPLE_TYPE_K 0
+#define THERMOCOUPLE_TYPE_J 1
+#define THERMOCOUPLE_TYPE_T 2
+#define THERMOCOUPLE_TYPE_E 3
+#define THERMOCOUPLE_TYPE_N 4
+#define THERMOCOUPLE_TYPE_R 5
+#define THERMOCOUPLE_TYPE_S 6
+#define THERMOCOUPLE_TYPE_B 7
+#define THERMOCOUPLE_TYPE_NROF 8
+
+// type letters in order of THERMOCOUPLE_TYPE_xxx
+#define THERMOCOUPLE_TYPE_LETTERS "KJTENRSB"
+
+typedef struct
+{
+    signed short temperature; // 0.1 degree
+    int24_t emf; // uV
+} THERMOCOUPLE_POINT;
+
+int24_t thermocouple_getEmf(unsigned char type, int24_t temperature);
+int24_t thermocouple_getTemperature(unsigned char type, int24_t emf);
+
+#endif
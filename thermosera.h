@@ -25,16 +25,71 @@
 #ifndef THERMOSERA_H
 #define	THERMOSERA_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define VERSION "0100"
 
 #define _XTAL_FREQ 48000000
 
-#define LINE_MAXLEN 30
+#define CHANNELS_NROF 4
+
+#define LINE_MAXLEN 12 // longest command ('Z5255') with terminator and margin
 #define BELL 7
 #define CR 13
 #define LR 10
 
+/* Scan interval, scans start on a fixed time grid */
+#define SCAN_INTERVAL_FREE 0 // next scan starts when the last one is finished
+#define SCAN_INTERVAL_100MS 1
+#define SCAN_INTERVAL_250MS 2
+#define SCAN_INTERVAL_500MS 3
+#define SCAN_INTERVAL_1S 4
+#define SCAN_INTERVAL_2S 5
+#define SCAN_INTERVAL_5S 6
+#define SCAN_INTERVAL_10S 7
+#define SCAN_INTERVAL_30S 8
+#define SCAN_INTERVAL_1MIN 9
+#define SCAN_INTERVAL_NROF 10
+
+/* Heartbeat of deadband reporting, silent channels are reported after it */
+#define REPORT_HEARTBEAT_OFF 0
+#define REPORT_HEARTBEAT_1S 1
+#define REPORT_HEARTBEAT_10S 2
+#define REPORT_HEARTBEAT_1MIN 3
+#define REPORT_HEARTBEAT_10MIN 4
+#define REPORT_HEARTBEAT_1H 5
+#define REPORT_HEARTBEAT_NROF 6
+
+#define OUTPUT_FORMAT_ASCII 0
+#define OUTPUT_FORMAT_BINARY 1
+
+/*
+ * Binary frame layout:
+ *   sync (0xA5), sequence counter, channel mask (bit 0-3: channel 1-4,
+ *   bit 4: ambient, bit 5: timestamps), 3 bytes per value in mask (24 bit
+ *   signed, MSB first, 0.1 degree) followed by 4 bytes timestamp if enabled
+ *   (32 bit ms since reset, MSB first), CRC-8 (polynom 0x07) over all bytes
+ *   except sync
+ */
+#define FRAME_SYNC 0xA5
+#define FRAME_MASK_CHANNELS 0x0F
+#define FRAME_MASK_AMBIENT 0x10
+#define FRAME_MASK_TIMESTAMPS 0x20
+#define FRAME_CRC_POLYNOM 0x07
+
+/* Temperature values are fixed-point with 0.1 degree resolution */
+#define VALUE_DECIMALS 1
+#define VALUE_WIDTH_ASCII 7
+
+/* Timestamps are appended as "@ms" in ASCII frames, up to 10 digits */
+#define STAMP_WIDTH_ASCII 11
+
+/* Marker for invalid values (read error, timeout) */
+#define VALUE_INVALID_ASCII "    ---"
+#define VALUE_INVALID_BINARY ((int24_t) 0x800000)
+
+/* Placeholder for channels without change in deadband reporting */
+#define VALUE_OMITTED_ASCII "       "
+
 #endif
 
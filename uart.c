@@ -24,29 +24,117 @@
 #include "thermosera.h"
 #include "uart.h"
 
+volatile unsigned char uart_txbuffer[UART_TXBUFFER_SIZE];
+volatile unsigned char uart_txbuffer_writepos = 0;
+volatile unsigned char uart_txbuffer_readpos = 0;
+unsigned short uart_txoverflow = 0;
+
+// baudrate change, applied by uart_process() when the characters put before
+// it are sent out, the interrupt routine holds back the following ones
+volatile unsigned char uart_baudrate_pending = UART_BAUDRATE_NROF; // none
+volatile unsigned char uart_baudrate_pos; // send buffer position of change
+
+// baudrate generator values for BRG16 = 1, BRGH = 1: Fosc / (4 * baud) - 1
+const unsigned short uart_brgvalues[UART_BAUDRATE_NROF] = {
+    1249, // 9600
+    624, // 19200
+    312, // 38400 (0.16% error)
+    207, // 57600 (0.16% error)
+    103, // 115200 (0.16% error)
+    51, // 230400 (0.16% error)
+    25, // 460800 (0.16% error)
+    12 // 921600 (0.16% error)
+};
+
 /**
  * @brief Initialize UART
  */
 void uart_init() {
 
-    // set baudrate to 9600
-    BAUDCON = 0x00;
-    SPBRGH = 0;
-    SPBRGL = 77;
+    // 16 bit baudrate generator, set baudrate to 9600
+    BAUDCON = 0b00001000;
+    SPBRGH = uart_brgvalues[UART_BAUDRATE_9600] >> 8;
+    SPBRGL = uart_brgvalues[UART_BAUDRATE_9600] & 0xff;
 
-    // enable transmitter
-    TXSTA = 0b00100000;
+    // enable transmitter, high speed
+    TXSTA = 0b00100100;
     RCSTA = 0b10010000;
 
 }
 
 /**
- * @brief Send character over UART
+ * @brief Set UART baudrate
+ *
+ * The characters already in the send buffer are sent out with the old
+ * baudrate, the new one is applied by uart_process() afterwards.
+ *
+ * @param baudrate Baudrate index (UART_BAUDRATE_xxx)
+ * @retval 1 Successful
+ * @retval 0 Invalid baudrate index
+ */
+unsigned char uart_setBaudrate(unsigned char baudrate) {
+
+    if (baudrate >= UART_BAUDRATE_NROF) return 0;
+
+    uart_baudrate_pos = uart_txbuffer_writepos;
+    uart_baudrate_pending = baudrate;
+
+    return 1;
+}
+
+/**
+ * @brief Apply pending baudrate change once the old characters are sent
+ */
+void uart_process() {
+
+    if (uart_baudrate_pending == UART_BAUDRATE_NROF) return;
+
+    // wait for send buffer and shift register
+    if (uart_txbuffer_readpos != uart_baudrate_pos) return;
+    if (TXSTAbits.TRMT == 0) return;
+
+    SPBRGH = uart_brgvalues[uart_baudrate_pending] >> 8;
+    SPBRGL = uart_brgvalues[uart_baudrate_pending] & 0xff;
+    uart_baudrate_pending = UART_BAUDRATE_NROF;
+
+    // continue with characters held back
+    if (uart_txbuffer_readpos != uart_txbuffer_writepos) TXIE = 1;
+}
+
+/**
+ * @brief Put character into UART send buffer (non-blocking)
  * @param ch Character to send
  */
 void uart_putch(unsigned char ch) {
-    while (TXSTAbits.TRMT == 0);
-    TXREG = ch;
+
+    unsigned char nextpos = (uart_txbuffer_writepos + 1) % UART_TXBUFFER_SIZE;
+    if (nextpos == uart_txbuffer_readpos) {
+        // overflow!
+        uart_txoverflow++;
+        return;
+    }
+
+    uart_txbuffer[uart_txbuffer_writepos] = ch;
+    uart_txbuffer_writepos = nextpos;
+
+    // (re)start draining the buffer from interrupt
+    TXIE = 1;
+}
+
+/**
+ * @brief UART transmit interrupt routine
+ */
+inline void uart_txisr() {
+
+    if ((uart_txbuffer_readpos == uart_txbuffer_writepos) ||
+            ((uart_baudrate_pending != UART_BAUDRATE_NROF) && (uart_txbuffer_readpos == uart_baudrate_pos))) {
+        // nothing left to send or baudrate change pending
+        TXIE = 0;
+        return;
+    }
+
+    TXREG = uart_txbuffer[uart_txbuffer_readpos];
+    uart_txbuffer_readpos = (uart_txbuffer_readpos + 1) % UART_TXBUFFER_SIZE;
 }
 
 /**
@@ -24,10 +24,27 @@
 #ifndef UART_H
 #define	UART_H
 
+#define UART_TXBUFFER_SIZE 64
+
+#define UART_BAUDRATE_9600 0
+#define UART_BAUDRATE_19200 1
+#define UART_BAUDRATE_38400 2
+#define UART_BAUDRATE_57600 3
+#define UART_BAUDRATE_115200 4
+#define UART_BAUDRATE_230400 5
+#define UART_BAUDRATE_460800 6
+#define UART_BAUDRATE_921600 7
+#define UART_BAUDRATE_NROF 8
+
 void uart_init();
+unsigned char uart_setBaudrate(unsigned char baudrate);
+void uart_process();
 void uart_putch(unsigned char ch);
 unsigned char uart_getch();
 unsigned char uart_chReceived();
+inline void uart_txisr();
+
+extern unsigned short uart_txoverflow;
 
 #endif
 
@@ -21,17 +21,20 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  * 
  */
-#include <xc.h>
+#include "hal.h"
 #include "usb_descr.h"
 #include "usb_cdc.h"
 
 
-volatile EndpointType ep[EP_MAX] @ 0x2000;
-volatile unsigned char ep0out_buffer[EP_BUFFERSIZE] @ 0x2020;
-volatile unsigned char ep0in_buffer[EP_BUFFERSIZE] @ 0x2028;
-volatile unsigned char ep1in_buffer[EP_BUFFERSIZE] @ 0x2030;
-volatile unsigned char ep2in_buffer[EP_BUFFERSIZE] @ 0x2038;
-volatile unsigned char ep3out_buffer[EP_BUFFERSIZE] @ 0x2040;
+volatile EndpointType ep0 HAL_AT(0x2000);
+volatile EndpointPingPongType ep1 HAL_AT(0x2008);
+volatile EndpointPingPongType ep2 HAL_AT(0x2018);
+volatile EndpointPingPongType ep3 HAL_AT(0x2028);
+volatile unsigned char ep0out_buffer[EP_BUFFERSIZE] HAL_AT(0x2038);
+volatile unsigned char ep0in_buffer[EP_BUFFERSIZE] HAL_AT(0x2040);
+volatile unsigned char ep2in_buffer[EP_BUFFERSIZE] HAL_AT(0x2048);
+volatile unsigned char ep1in_buffer[2][EP_BULK_BUFFERSIZE] HAL_AT(0x2050);
+volatile unsigned char ep3out_buffer[2][EP_BULK_BUFFERSIZE] HAL_AT(0x20D0);
 
 unsigned short usb_sendleft = 0;
 const unsigned char * usb_sendbuffer;
@@ -41,51 +44,99 @@ unsigned char usb_setaddress = 0;
 unsigned char usb_ep0status[2];
 unsigned char usb_hidreportid;
 
-unsigned char usb_getchpos = 0;
+unsigned char usb_ep1in_odd = 0; // next EP1 IN buffer to fill
+unsigned char usb_ep1in_zlp = 0; // last packet had full size, terminate transfer
+unsigned char usb_ep3out_odd = 0; // next EP3 OUT buffer to read
+unsigned char usb_ep3out_held = 0; // EP3 OUT buffer handed to application
+unsigned char usb_ep3out_stale = 0; // held buffer was re-armed by endpoint reset
 unsigned char linecoding[7];
 unsigned char dolinecoding = 0;
+unsigned char usb_dtr = 0; // port opened by host (DTR of SET_CONTROL_LINE_STATE)
 
+// send buffer, written by application, read by interrupt routine up to the
+// write position published by usb_txCommit()
 unsigned char txbuffer[TXBUFFER_SIZE];
-unsigned char txbuffer_writepos = 0;
-unsigned char txbuffer_bytesleft = 0;
+unsigned char txbuffer_fillpos = 0;
+volatile unsigned char txbuffer_writepos = 0;
+volatile unsigned char txbuffer_readpos = 0;
+unsigned short usb_txdropped = 0; // frames and replies dropped because of full send buffer
+unsigned char usb_txhighwater = 0; // maximum fill level of send buffer
+
+volatile unsigned char usb_suspended = 0; // bus idle: 1 not reported yet, 2 reported
+
+/**
+ * @brief Reset ping-pong pointers and data toggles of the data endpoints
+ *
+ * Both EP3 OUT buffers are armed, so the host can send the next packet
+ * while the previous one is parsed. A buffer held by the application at
+ * that time is marked stale, so usb_releaseBlock() doesn't arm it again
+ * and the ping-pong order is kept.
+ */
+void usb_resetDataEndpoints() {
+
+    UCONbits.PPBRST = 1;
+
+    ep1.in[0].stat = 0;
+    ep1.in[1].stat = 0;
+    usb_ep1in_odd = 0;
+    usb_ep1in_zlp = 0;
+
+    ep3.out[0].cnt = EP_BULK_BUFFERSIZE;
+    ep3.out[0].stat = 0x80;
+    ep3.out[1].cnt = EP_BULK_BUFFERSIZE;
+    ep3.out[1].stat = 0x80;
+    usb_ep3out_odd = 0;
+    usb_ep3out_stale = usb_ep3out_held;
+
+    UCONbits.PPBRST = 0;
+}
 
 /**
  * @brief Initialize USB stack
  */
 void usb_init() {
-    ep[0].out.stat = 0x80;
-    ep[0].out.cnt = EP_BUFFERSIZE;
-    ep[0].out.adrl = 0x20;
-    ep[0].out.adrh = 0x20;
-
-    ep[0].in.stat = 0;
-    ep[0].in.cnt = EP_BUFFERSIZE;
-    ep[0].in.adrl = 0x28;
-    ep[0].in.adrh = 0x20;
-
-    ep[1].in.stat = 0x40;
-    ep[1].in.cnt = EP_BUFFERSIZE;
-    ep[1].in.adrl = 0x30;
-    ep[1].in.adrh = 0x20;
-
-    ep[2].in.stat = 0;
-    ep[2].in.cnt = EP_BUFFERSIZE;
-    ep[2].in.adrl = 0x38;
-    ep[2].in.adrh = 0x20;
-
-    ep[3].out.stat = 0x80;
-    ep[3].out.cnt = EP_BUFFERSIZE;
-    ep[3].out.adrl = 0x40;
-    ep[3].out.adrh = 0x20;
+    ep0.out.stat = 0x80;
+    ep0.out.cnt = EP_BUFFERSIZE;
+    ep0.out.adrl = 0x38;
+    ep0.out.adrh = 0x20;
+
+    ep0.in.stat = 0;
+    ep0.in.cnt = EP_BUFFERSIZE;
+    ep0.in.adrl = 0x40;
+    ep0.in.adrh = 0x20;
+
+    ep2.in[0].stat = 0;
+    ep2.in[0].cnt = EP_BUFFERSIZE;
+    ep2.in[0].adrl = 0x48;
+    ep2.in[0].adrh = 0x20;
+    ep2.in[1].stat = 0;
+    ep2.in[1].cnt = EP_BUFFERSIZE;
+    ep2.in[1].adrl = 0x48;
+    ep2.in[1].adrh = 0x20;
+
+    ep1.in[0].adrl = 0x50;
+    ep1.in[0].adrh = 0x20;
+    ep1.in[1].adrl = 0x90;
+    ep1.in[1].adrh = 0x20;
+
+    ep3.out[0].adrl = 0xD0;
+    ep3.out[0].adrh = 0x20;
+    ep3.out[1].adrl = 0x10;
+    ep3.out[1].adrh = 0x21;
+
+    usb_resetDataEndpoints();
 
     UEP0 = 0x16; // enable IN, enable OUT, enable CONTROL, enable handshake
     UEP1 = 0x1A; // enable IN, disable OUT, disable CONTROL, enable handshake
     UEP2 = 0x1A; // enable IN, disable OUT, disable CONTROL, enable handshake
     UEP3 = 0x1C; // disable OUT, enable IN, disable CONTROL, enable handshake
 
-    UCFG = 0x14; // enable pullup and full-speed
+    UCFG = 0x17; // enable pullup and full-speed, ping-pong on all but EP0
     UCON = 0x08; // enable usb module
 
+    UIE = 0x59; // interrupt on SOF, idle, transaction and reset
+    USBIE = 1;
+
     usb_ep0status[0] = 0; usb_ep0status[1] = 0;
 }
 
@@ -93,6 +144,7 @@ void usb_init() {
  * @brief Shutdown USB stack
  */
 void usb_shutdown() {
+    USBIE = 0;
     UCON = 0x00;
     UCFG = 0x00;
 }
@@ -125,11 +177,11 @@ void usb_sendProcess() {
         usb_sendleft--;
     }
 
-    ep[0].in.cnt = length;
-    if (ep[0].in.stat & 0x40)
-        ep[0].in.stat = 0x88;
+    ep0.in.cnt = length;
+    if (ep0.in.stat & 0x40)
+        ep0.in.stat = 0x88;
     else
-        ep[0].in.stat = 0xC8;
+        ep0.in.stat = 0xC8;
 }
 
 
@@ -187,18 +239,87 @@ unsigned char usb_handleDescriptorRequest(unsigned char type, unsigned char inde
  */
 void usb_putch(unsigned char ch) {
 
-    if (txbuffer_bytesleft == TXBUFFER_SIZE) {
+    unsigned char nextpos = (txbuffer_fillpos + 1) % TXBUFFER_SIZE;
+    if (nextpos == txbuffer_readpos) {
         // overflow!
         return;
     }
 
-    txbuffer[txbuffer_writepos] = ch;
-    txbuffer_writepos++;
-    if (txbuffer_writepos == TXBUFFER_SIZE) txbuffer_writepos = 0;
-    txbuffer_bytesleft++;
+    txbuffer[txbuffer_fillpos] = ch;
+    txbuffer_fillpos = nextpos;
 
 }
 
+/**
+ * @brief Release the characters put into the send buffer since last commit
+ *
+ * Called after each complete frame or reply, so a packet never ends in
+ * the middle of one while the rest is still being written.
+ */
+void usb_txCommit() {
+    txbuffer_writepos = txbuffer_fillpos;
+}
+
+/**
+ * @brief Determine if the port is opened by the host
+ *
+ * @retval 1 device configured and DTR set
+ * @retval 0 nobody is listening
+ */
+unsigned char usb_isOpen() {
+    return configured && usb_dtr;
+}
+
+/**
+ * @brief Determine if the host has suspended the bus since last call
+ *
+ * A suspend is reported once, until frames are sent on the bus again.
+ *
+ * @retval 1 bus suspended
+ * @retval 0 no new suspend
+ */
+unsigned char usb_checkSuspend() {
+    if (usb_suspended != 1) return 0;
+    usb_suspended = 2;
+    return 1;
+}
+
+/**
+ * @brief Get free space in send buffer
+ *
+ * @return Count of characters which can be put into send buffer
+ */
+unsigned char usb_txFree() {
+    return (TXBUFFER_SIZE - 1 + txbuffer_readpos - txbuffer_fillpos) % TXBUFFER_SIZE;
+}
+
+/**
+ * @brief Reserve space in send buffer for a frame or reply
+ *
+ * The interrupt routine only frees space, so the given count of characters
+ * can be put into the send buffer without overflow after a successful
+ * reservation. A failed reservation of an opened port counts as dropped
+ * frame or reply.
+ *
+ * @param count Count of characters to send
+ * @retval 1 frame fits into send buffer
+ * @retval 0 port closed or send buffer too full
+ */
+unsigned char usb_txReserve(unsigned char count) {
+
+    if (!usb_isOpen()) return 0;
+
+    unsigned char free = usb_txFree();
+    if (count > free) {
+        usb_txdropped++;
+        return 0;
+    }
+
+    unsigned char used = TXBUFFER_SIZE - 1 - free + count;
+    if (used > usb_txhighwater) usb_txhighwater = used;
+    return 1;
+}
+
 /**
  * @brief Put given nullterminated string into send buffer
  *
@@ -213,68 +334,124 @@ void usb_putstr(char * s) {
 
 /**
  * @brief Handle pending transmition
+ *
+ * EP1 IN is ping-pong buffered, both buffers are filled if there is enough
+ * data, so the next packet is ready while the previous one is sent. The
+ * buffers alternate with every transaction like the data toggle, so the
+ * even buffer always carries DATA0 and the odd one DATA1.
+ *
+ * A transfer ends with a short packet, so a full size packet without
+ * further data is followed by a zero length packet.
  */
 void usb_txprocess() {
-    if (txbuffer_bytesleft == 0) return;
     if (!configured) return;
-    if (ep[1].in.stat & 0x80) return;
 
-    unsigned char count = txbuffer_bytesleft;
-    if (count > EP_BUFFERSIZE - 1) count = EP_BUFFERSIZE - 1;
+    while (1) {
 
-    unsigned char readpos = (TXBUFFER_SIZE + txbuffer_writepos - txbuffer_bytesleft) % TXBUFFER_SIZE;    
+        unsigned char count = (TXBUFFER_SIZE + txbuffer_writepos - txbuffer_readpos) % TXBUFFER_SIZE;
+        if ((count == 0) && !usb_ep1in_zlp) return;
 
-    unsigned char i;
-    for (i = 0; i < count; i++) {
-        ep1in_buffer[i] = txbuffer[readpos];
-        readpos ++;
-        if (readpos == TXBUFFER_SIZE) readpos = 0;
-    } 
+        volatile BDT * bd = &ep1.in[usb_ep1in_odd];
+        if (bd->stat & 0x80) return;
 
-    ep[1].in.cnt = count;
-    txbuffer_bytesleft -= count;
+        if (count > EP_BULK_BUFFERSIZE) count = EP_BULK_BUFFERSIZE;
 
-    if (ep[1].in.stat & 0x40)
-        ep[1].in.stat = 0x88;
-    else
-        ep[1].in.stat = 0xC8;
+        unsigned char readpos = txbuffer_readpos;
+
+        volatile unsigned char * buffer = ep1in_buffer[usb_ep1in_odd];
+        unsigned char i;
+        for (i = 0; i < count; i++) {
+            buffer[i] = txbuffer[readpos];
+            readpos ++;
+            if (readpos == TXBUFFER_SIZE) readpos = 0;
+        }
+
+        bd->cnt = count;
+        txbuffer_readpos = readpos;
+        usb_ep1in_zlp = (count == EP_BULK_BUFFERSIZE);
+
+        if (usb_ep1in_odd)
+            bd->stat = 0xC8;
+        else
+            bd->stat = 0x88;
+
+        usb_ep1in_odd ^= 1;
+    }
+}
+
+/**
+ * @brief Handle USB bus reset
+ */
+void usb_reset() {
+
+    // flush transaction status FIFO
+    while (UIRbits.TRNIF) UIRbits.TRNIF = 0;
+
+    UADDR = 0;
+    usb_setaddress = 0;
+    usb_config = 0;
+    usb_sendleft = 0;
+    dolinecoding = 0;
+    usb_dtr = 0;
+    configured = 0;
+
+    ep0.out.cnt = EP_BUFFERSIZE;
+    ep0.out.stat = 0x80;
+    ep0.in.stat = 0;
+
+    usb_resetDataEndpoints();
+
+    UCONbits.PKTDIS = 0;
 }
 
 /**
- * @brief Do USB stack processing
+ * @brief USB interrupt routine
+ *
+ * The whole device stack runs here. The application only uses the send
+ * buffer (usb_putch, usb_txCommit) and the EP3 OUT buffers (usb_getBlock),
+ * which are shared lock-free with this routine.
  */
-void usb_process() {
+inline void usb_isr() {
+
+    if (UIRbits.URSTIF) {
+        usb_reset();
+        UIRbits.URSTIF = 0;
+    }
+
+    if (UIRbits.IDLEIF) {
+        // bus idle, the host suspends the device
+        if (configured && !usb_suspended) usb_suspended = 1;
+        UIRbits.IDLEIF = 0;
+    }
 
-    usb_txprocess();
-    
-    if (UIRbits.TRNIF) {
+    while (UIRbits.TRNIF) {
         // complete interrupt
 
         if (USTAT == USTAT_EP0_OUT) {
 
             // out/setup
 
-            if (((ep[0].out.stat >> 2) & 0x0F) == USB_PID_SETUP) {
+            if (((ep0.out.stat >> 2) & 0x0F) == USB_PID_SETUP) {
                 // setup token
 
-                ep[0].in.stat = 0;
-                ep[0].in.stat = 0;
+                ep0.in.stat = 0;
+                ep0.in.stat = 0;
 
                 if ((ep0out_buffer[0] & USBRQ_TYPE_MASK) == USBRQ_TYPE_STANDARD) {
 
                         switch (ep0out_buffer[1]) {
                             case REQUEST_GET_DESCRIPTOR:
                                 if (!usb_handleDescriptorRequest(ep0out_buffer[3], ep0out_buffer[2] , (ep0out_buffer[7] << 8) | ep0out_buffer[6])) {
-                                    ep[0].in.cnt = 0;
-                                    ep[0].in.stat = 0xCC; // Stall
+                                    ep0.in.cnt = 0;
+                                    ep0.in.stat = 0xCC; // Stall
                                 }
                                 break;
                             case REQUEST_SET_ADDRESS:
 
                                 usb_setaddress = ep0out_buffer[2];
 
-                                ep[0].in.cnt = 0;
-                                ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 0;
+                                ep0.in.stat = 0xC8;
 
                                 break;
 
@@ -282,22 +459,23 @@ void usb_process() {
 
                                 usb_config = ep0out_buffer[2];
                                 configured = 1;
-                                ep[0].in.cnt = 0;
-                                ep[0].in.stat = 0xC8;
+                                usb_resetDataEndpoints();
+                                ep0.in.cnt = 0;
+                                ep0.in.stat = 0xC8;
                                 break;
 
                             case REQUEST_GET_CONFIGURATION:
 
                                 ep0in_buffer[0] = usb_config;
-                                ep[0].in.cnt = 1;
-                                ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 1;
+                                ep0.in.stat = 0xC8;
                                 break;
 
                             case REQUEST_GET_INTERFACE:
 
                                 ep0in_buffer[0] = 0;
-                                ep[0].in.cnt = 1;
-                                ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 1;
+                                ep0.in.stat = 0xC8;
                                 break;
                                 
                             case REQUEST_GET_STATUS:
@@ -308,8 +486,8 @@ void usb_process() {
                                     ep0in_buffer[0] = 0;
                                     ep0in_buffer[1] = 0;
                                 }
-                                ep[0].in.cnt = 2;
-		                        ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 2;
+		                        ep0.in.stat = 0xC8;
                                 break;
 
                             case REQUEST_SET_FEATURE:
@@ -317,33 +495,33 @@ void usb_process() {
                                     if (ep0out_buffer[2] == 0x00) // HALT
                                         usb_ep0status[0] = 1;
                                 }
-                                ep[0].in.cnt = 0;
-		                        ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 0;
+		                        ep0.in.stat = 0xC8;
 		                        break;   
                                 
                             case REQUEST_CLEAR_FEATURE:
                                 if ((ep0out_buffer[0] & USBRQ_RECIPIENT_MASK) == USBRQ_RECIPIENT_ENDPOINT) {
                                     usb_ep0status[0] = 0;                                    
                                 }
-                                ep[0].in.cnt = 0;
-		                        ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 0;
+		                        ep0.in.stat = 0xC8;
 		                        break;   
                                 
                             case REQUEST_SYNCH_FRAME:
                                 ep0in_buffer[0] = 0;
                                 ep0in_buffer[1] = 0;
-                                ep[0].in.cnt = 2;
-                                ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 2;
+                                ep0.in.stat = 0xC8;
                                 break;
 
                             case REQUEST_SET_INTERFACE:
-                                ep[0].in.cnt = 0;
-                                ep[0].in.stat = 0xC8;
+                                ep0.in.cnt = 0;
+                                ep0.in.stat = 0xC8;
                                 break;
                                 
                             default:
-                                ep[0].in.cnt = 0;
-                                ep[0].in.stat = 0xCC; // stall
+                                ep0.in.cnt = 0;
+                                ep0.in.stat = 0xCC; // stall
                                 break;
 
                         }
@@ -358,14 +536,14 @@ void usb_process() {
                                 ep0in_buffer[i] = 0;
                             }
                         };
-                            ep[0].in.cnt = 8;
-                            ep[0].in.stat = 0xC8;
+                            ep0.in.cnt = 8;
+                            ep0.in.stat = 0xC8;
                             break;
 
                         case REQUEST_SET_LINE_CODING:
                             dolinecoding = 1;
-                            ep[0].in.cnt = 0;
-                            ep[0].in.stat = 0xC8;
+                            ep0.in.cnt = 0;
+                            ep0.in.stat = 0xC8;
                             break;
 
                         case REQUEST_GET_LINE_CODING:
@@ -375,18 +553,23 @@ void usb_process() {
                                 ep0in_buffer[i] = linecoding[i];
                             }
                         }
-                            ep[0].in.cnt = 7;
-                            ep[0].in.stat = 0xC8;
+                            ep0.in.cnt = 7;
+                            ep0.in.stat = 0xC8;
                             break;
 
                         case REQUEST_SET_CONTROL_LINE_STATE:
+                            usb_dtr = ep0out_buffer[2] & 0x01;
+                            ep0.in.cnt = 0;
+                            ep0.in.stat = 0xC8;
+                            break;
+
                         case REQUEST_SEND_ENCAPSULATED_COMMAND:
-                            ep[0].in.cnt = 0;
-                            ep[0].in.stat = 0xC8;
+                            ep0.in.cnt = 0;
+                            ep0.in.stat = 0xC8;
                             break;
                         default:
-                            ep[0].in.cnt = 0;
-                            ep[0].in.stat = 0xCC; // Stall
+                            ep0.in.cnt = 0;
+                            ep0.in.stat = 0xCC; // Stall
                             break;
                     }
 
@@ -406,8 +589,8 @@ void usb_process() {
 
             }
 
-            ep[0].out.cnt = EP_BUFFERSIZE;
-            ep[0].out.stat = 0x80;
+            ep0.out.cnt = EP_BUFFERSIZE;
+            ep0.out.stat = 0x80;
 
 
         } else if (USTAT == USTAT_EP0_IN) {
@@ -420,39 +603,77 @@ void usb_process() {
 
                 usb_sendProcess();
 
-        } 
+        } else if ((USTAT & ~0x02) == USTAT_EP1_IN) {
+
+                // refill the buffer just sent (PPBI masked)
+                usb_txprocess();
+
+        }
 
         UCONbits.PKTDIS = 0;
         UIRbits.TRNIF = 0;
     }
+
+    if (UIRbits.SOFIF) {
+        usb_suspended = 0;
+
+        // pick up data put into send buffer since last frame
+        usb_txprocess();
+        UIRbits.SOFIF = 0;
+    }
+
+    USBIF = 0;
 }
 
 
 
 /**
- * @brief Determine if there are received characters
+ * @brief Get next received block
+ *
+ * The data is left in the endpoint buffer and may be modified by the
+ * caller. The other buffer keeps receiving until usb_releaseBlock() is
+ * called.
  *
- * @retval 1 if there are characters in the receive buffer
- * @retval 0 receive buffer empty
+ * @param data Set to begin of received data
+ * @return Count of received bytes, 0 if nothing received
  */
-unsigned char usb_chReceived() {
-    return (ep[3].out.stat & 0x80) == 0;
+unsigned char usb_getBlock(char ** data) {
+
+    unsigned char count = 0;
+
+    // the interrupt routine resets the endpoint on SET_CONFIGURATION
+    USBIE = 0;
+
+    volatile BDT * bd = &ep3.out[usb_ep3out_odd];
+    if (!(bd->stat & 0x80)) {
+        usb_ep3out_held = 1;
+        count = bd->cnt;
+        *data = (char *) ep3out_buffer[usb_ep3out_odd];
+    }
+
+    USBIE = 1;
+
+    // zero length packet
+    if (usb_ep3out_held && (count == 0)) usb_releaseBlock();
+
+    return count;
 }
 
 /**
- * @brief Read character from receive buffer
- *
- * @return Character read from receive buffer
+ * @brief Hand buffer of last received block back to the USB module
  */
-unsigned char usb_getch() {
-    while (!usb_chReceived) {}
-
-    unsigned char ch = ep3out_buffer[usb_getchpos];
-    usb_getchpos++;
-    if (usb_getchpos == ep[3].out.cnt) {
-        ep[3].out.cnt = EP_BUFFERSIZE;
-        ep[3].out.stat = 0x80;
-        usb_getchpos = 0;
+void usb_releaseBlock() {
+
+    USBIE = 0;
+
+    if (!usb_ep3out_stale) {
+        volatile BDT * bd = &ep3.out[usb_ep3out_odd];
+        bd->cnt = EP_BULK_BUFFERSIZE;
+        bd->stat = 0x80;
+        usb_ep3out_odd ^= 1;
     }
-    return ch;
-}
\ No newline at end of file
+    usb_ep3out_stale = 0;
+    usb_ep3out_held = 0;
+
+    USBIE = 1;
+}
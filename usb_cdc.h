@@ -26,11 +26,19 @@
 
 void usb_init();
 void usb_shutdown();
-void usb_process();
-unsigned char usb_chReceived();
-unsigned char usb_getch();
+inline void usb_isr();
+unsigned char usb_getBlock(char ** data);
+void usb_releaseBlock();
 void usb_putch(unsigned char ch);
 void usb_putstr(char * s);
+void usb_txCommit();
+unsigned char usb_isOpen();
+unsigned char usb_checkSuspend();
+unsigned char usb_txFree();
+unsigned char usb_txReserve(unsigned char count);
+
+extern unsigned short usb_txdropped;
+extern unsigned char usb_txhighwater;
 
 #define USB_PID_SETUP 0xD
 
@@ -73,8 +81,9 @@ void usb_putstr(char * s);
 /* Endpoint definitions */
 #define EP_MAX 4
 #define EP_BUFFERSIZE 8
+#define EP_BULK_BUFFERSIZE 64 // EP1 IN, EP3 OUT
 
-#define TXBUFFER_SIZE 64 //128
+#define TXBUFFER_SIZE 128 // ASCII frame with timestamps
 
 typedef struct
 {
@@ -90,11 +99,20 @@ typedef struct
 	BDT in;
 } EndpointType;
 
+/* Endpoint with ping-pong buffering (UCFG PPB = 11: all but EP0) */
+typedef struct
+{
+	BDT out[2]; // even, odd
+	BDT in[2]; // even, odd
+} EndpointPingPongType;
+
 
 #define USB_DEV_DESC_SERIALNUMBER_OFFSET 16
 #define USB_STRING_SERIALNUMBER_INDEX 3
 #define USB_STRING_SERIALNUMBER_SIZE 18
-const unsigned char usb_string_serial[] @ 0x0700;
+#ifndef HAL_HOST
+const unsigned char usb_string_serial[] HAL_AT(0x0700);
+#endif
 
 #endif
 
@@ -122,7 +122,7 @@ const unsigned char usb_config_desc[] = {
         DESCR_ENDPOINT,   /* bDescriptorType: Endpoint */
         0x03,   /* bEndpointAddress: (OUT3) */
         0x02,   /* bmAttributes: Bulk */
-        0x08,             /* wMaxPacketSize: */
+        0x40,             /* wMaxPacketSize: */
         0x00,
         0x00,   /* bInterval: ignore for Bulk transfer */
 /*Endpoint 1 Descriptor*/
@@ -130,7 +130,7 @@ const unsigned char usb_config_desc[] = {
         DESCR_ENDPOINT,   /* bDescriptorType: Endpoint */
         0x81,   /* bEndpointAddress: (IN1) */
         0x02,   /* bmAttributes: Bulk */
-        0x08,             /* wMaxPacketSize: */
+        0x40,             /* wMaxPacketSize: */
         0x00,
         0x00    /* bInterval: ignore for Bulk transfer */
 };